@@ -55,6 +55,7 @@ function nodeShort(version) {
 }
 
 function sizeLabel(bytes) {
+  if (bytes >= 2 ** 30) return (bytes / 2 ** 30) + 'GB';
   if (bytes >= 1 << 20) return (bytes >> 20) + 'MB';
   if (bytes >= 1 << 10) return (bytes >> 10) + 'KB';
   return bytes + 'B';
@@ -87,7 +88,9 @@ md += '|----------|----------|------|';
 for (let i = 0; i < hashColumns.length; i++) md += '------:|';
 md += '\n';
 
-for (const bench of benchmarks) {
+// Latency runs (benchmark.js --latency) have no headline; they only add a
+// detail table.
+for (const bench of benchmarks.filter(b => b.headline || b.results)) {
   const meta = bench.metadata;
   const cells = [
     platformLabel(meta),
@@ -110,12 +113,33 @@ md += `\n*Generated at ${new Date().toISOString()} with xxHash v0.8.3*\n`;
 // ── Detailed sweep tables (for Job Summary only) ──
 let detail = '';
 
-for (const section of ['streaming', 'oneshot']) {
+const sectionTitles = {
+  streaming: 'Streaming Throughput by Buffer Size',
+  oneshot: 'One-shot Throughput by Buffer Size',
+  batch: 'Batch Throughput by Record Size',
+  files: 'File Hashing Throughput by File Size',
+  results: 'Result Allocation Throughput by Input Size',
+  strings: 'String Key Throughput by Key Size',
+  seeded: 'Seeded One-shot Throughput by Input Size',
+  clones: 'Shared Prefix Throughput by Prefix Size',
+  columns: 'Columnar Throughput by Row Key Width',
+  chunks: 'Content-Defined Chunking Throughput by Data Size',
+  membership: 'Membership Throughput by Key Size',
+  simd: 'XXH3 Throughput by SIMD Backend',
+  latency: 'Small-input Latency by Input Size',
+};
+
+// Unit and result field of each table; throughput unless listed here.
+const sectionUnits = {
+  latency: ['ns/call', 'median_ns'],
+};
+
+for (const section of Object.keys(sectionTitles)) {
   // Check if any benchmark has this section
   if (!benchmarks.some(b => b[section] && b[section].length > 0)) continue;
 
-  const title = section === 'streaming' ? 'Streaming' : 'One-shot';
-  detail += `\n### ${title} Throughput by Buffer Size (GB/s)\n\n`;
+  const [unit, field] = sectionUnits[section] || ['GB/s', 'median_gbps'];
+  detail += `\n### ${sectionTitles[section]} (${unit})\n\n`;
 
   // Collect all sizes from the first benchmark that has this section
   const ref = benchmarks.find(b => b[section] && b[section].length > 0);
@@ -134,7 +158,10 @@ for (const section of ['streaming', 'oneshot']) {
     const data = bench[section];
     if (!data || data.length === 0) continue;
 
-    for (const name of hashColumns) {
+    const names = section === 'streaming' || section === 'oneshot'
+      ? hashColumns
+      : [...new Set(data.map(r => r.name))];
+    for (const name of names) {
       const cells = [
         platformLabel(meta),
         compilerShort(meta.compiler),
@@ -142,7 +169,7 @@ for (const section of ['streaming', 'oneshot']) {
       ];
       for (const s of sizes) {
         const r = data.find(x => x.name === name && x.size_bytes === s);
-        cells.push(r ? r.median_gbps.toFixed(2) : '-');
+        cells.push(r ? r[field].toFixed(2) : '-');
       }
       detail += `| ${cells.join(' | ')} |\n`;
     }
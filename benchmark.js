@@ -1,9 +1,13 @@
 'use strict';
-const { XXHash128, XXHash3, XXHash64 } = require('./xxhash-addon');
+const {
+  XXHash128, XXHash3, XXHash64, XXHash32, XXH3Secret, Chunker, XXH3BloomFilter, XXH3HashSet,
+  getSimdBackend, setSimdBackend, listSimdBackends, _nativeHashLoop, getStats,
+} = require('./xxhash-addon');
 const crypto = require('crypto');
-const { performance } = require('perf_hooks');
+const { performance, PerformanceObserver } = require('perf_hooks');
 const os = require('os');
 const fs = require('fs');
+const path = require('path');
 
 // ── Sanitizer guard ──
 if (process.env.DEBUG === '1') {
@@ -20,6 +24,26 @@ const TARGET_MS = 1000;     // target ~1 s per measured run
 const WARMUP = 2;
 const RUNS = 5;
 const HEADLINE_CHUNK = 65536;
+const RECORD_SIZES = [16, 64, 256, 512, 1024];
+const BATCH_RECORDS = 4096;
+const RESULT_SIZES = [16, 256];
+const KEY_SIZES = [16, 64, 256, 4096];
+const SEEDED_SIZES = [16, 256, 4096];
+const PREFIX_SIZES = [256, 4096];
+const MESSAGE_SIZE = 64;
+const COLUMN_ROWS = 1 << 18;
+const CHUNK_DATA_SIZES = [1048576, 16777216];
+const MEMBERSHIP_KEYS = 1 << 20;
+const MEMBERSHIP_KEY_SIZES = [8, 32];
+const SIMD_SIZES = [4096, 65536, 1048576];
+const LATENCY_MODE = process.argv.includes('--latency');
+const LATENCY_SIZES = [8, 16, 32, 64, 128, 256];
+const LATENCY_TARGET_MS = 200;   // per measured run; latency mode has ~120 rows
+const MAX_REGRESSION = Number(process.env.BENCHMARK_MAX_REGRESSION || 0.2);
+// Multi-GB files can be added with e.g. BENCHMARK_FILE_SIZES=4096,4294967296
+const FILE_SIZES = process.env.BENCHMARK_FILE_SIZES
+  ? process.env.BENCHMARK_FILE_SIZES.split(',').map(Number)
+  : [4096, 262144, 16777216, 268435456];
 const SEED = Buffer.alloc(8, 0);
 const HAS_CRYPTO_HASH = typeof crypto.hash === 'function';
 
@@ -39,6 +63,7 @@ function median(arr) {
 }
 
 function sizeLabel(bytes) {
+  if (bytes >= 2 ** 30) return (bytes / 2 ** 30) + 'GB';
   if (bytes >= 1 << 20) return (bytes >> 20) + 'MB';
   if (bytes >= 1 << 10) return (bytes >> 10) + 'KB';
   return bytes + 'B';
@@ -47,13 +72,13 @@ function sizeLabel(bytes) {
 function round3(n) { return Math.round(n * 1000) / 1000; }
 
 // ── Calibrate: find iteration count targeting ~TARGET_MS ──
-function calibrate(fn) {
+function calibrate(fn, targetMs = TARGET_MS) {
   let n = 1;
   for (;;) {
     const t0 = performance.now();
     fn(n);
     const ms = performance.now() - t0;
-    if (ms >= 100) return Math.max(1, Math.round(n * TARGET_MS / ms));
+    if (ms >= 100) return Math.max(1, Math.round(n * targetMs / ms));
     n = ms < 1 ? n * 100 : Math.ceil(n * 200 / ms);
     if (n > 2e9) return n;
   }
@@ -87,6 +112,71 @@ function measure(label, fn, bytesPerIter) {
   };
 }
 
+// ── Latency variant of measure: ns per call instead of GB/s ──
+function measureLatency(label, fn) {
+  process.stdout.write(`${label} ...`);
+  const n = calibrate(fn, LATENCY_TARGET_MS);
+
+  for (let i = 0; i < WARMUP; i++) fn(n);
+
+  const times = [];
+  for (let i = 0; i < RUNS; i++) {
+    const t0 = performance.now();
+    fn(n);
+    times.push(performance.now() - t0);
+  }
+
+  const toNs = (ms) => round3(ms * 1e6 / n);
+  const med = median(times);
+
+  process.stdout.write(` ${toNs(med)} ns/call\n`);
+
+  return {
+    median_ns: toNs(med),
+    min_ns: toNs(Math.min(...times)),
+    max_ns: toNs(Math.max(...times)),
+    calls_per_sec: Math.round(n / (med / 1000)),
+  };
+}
+
+// ── Async variants of calibrate/measure for Promise-returning fn(n) ──
+async function calibrateAsync(fn) {
+  let n = 1;
+  for (;;) {
+    const t0 = performance.now();
+    await fn(n);
+    const ms = performance.now() - t0;
+    if (ms >= 100) return Math.max(1, Math.round(n * TARGET_MS / ms));
+    n = ms < 1 ? n * 100 : Math.ceil(n * 200 / ms);
+  }
+}
+
+async function measureAsync(label, fn, bytesPerIter) {
+  process.stdout.write(`${label} ...`);
+  const n = await calibrateAsync(fn);
+
+  for (let i = 0; i < WARMUP; i++) await fn(n);
+
+  const times = [];
+  for (let i = 0; i < RUNS; i++) {
+    const t0 = performance.now();
+    await fn(n);
+    times.push(performance.now() - t0);
+  }
+
+  const totalBytes = n * bytesPerIter;
+  const toGbps = (ms) => round3((totalBytes / (1 << 30)) / (ms / 1000));
+  const med = median(times);
+
+  process.stdout.write(` ${toGbps(med)} GB/s\n`);
+
+  return {
+    median_gbps: toGbps(med),
+    min_gbps: toGbps(Math.max(...times)),
+    max_gbps: toGbps(Math.min(...times)),
+  };
+}
+
 // ── Hasher definitions ──
 const XXHASHERS = [['XXH64', XXHash64], ['XXH3', XXHash3], ['XXH128', XXHash128]];
 const CRYPTO_ALGOS = [['MD5', 'md5'], ['SHA1', 'sha1']];
@@ -164,6 +254,550 @@ function oneshotSweep() {
   return results;
 }
 
+// ═══════════════════════════════════════════
+// Part 3: Batch one-shot throughput vs. per-record loop
+// ═══════════════════════════════════════════
+function batchSweep() {
+  console.log('\n── Batch one-shot throughput ──');
+  const results = [];
+
+  for (const size of RECORD_SIZES) {
+    const packed = Buffer.alloc(size * BATCH_RECORDS);
+    crypto.randomFillSync(packed);
+    const offsets = new Uint32Array(BATCH_RECORDS + 1);
+    const records = [];
+    for (let i = 0; i < BATCH_RECORDS; i++) {
+      offsets[i + 1] = (i + 1) * size;
+      records.push(packed.subarray(i * size, (i + 1) * size));
+    }
+    const out = Buffer.alloc(BATCH_RECORDS * 16);
+    console.log(`\n${sizeLabel(size)} x ${BATCH_RECORDS} records:`);
+
+    for (const [name, Cls] of XXHASHERS) {
+      const modes = [
+        ['loop', (n) => {
+          for (let i = 0; i < n; i++) {
+            for (let j = 0; j < BATCH_RECORDS; j++) Cls.hash(records[j]);
+          }
+        }],
+        ['array', (n) => {
+          for (let i = 0; i < n; i++) Cls.hashBatch(records, out);
+        }],
+        ['offsets', (n) => {
+          for (let i = 0; i < n; i++) Cls.hashBatch(packed, offsets, out);
+        }],
+      ];
+      for (const [mode, fn] of modes) {
+        const r = measure(`  ${name} ${mode}`, fn, size * BATCH_RECORDS);
+        results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 4: File hashing, native hashFile() vs. fs.createReadStream()
+// ═══════════════════════════════════════════
+function writeTestFile(file, size) {
+  const block = Buffer.alloc(Math.min(size, 16 << 20));
+  crypto.randomFillSync(block);
+  const fd = fs.openSync(file, 'w');
+  try {
+    for (let written = 0; written < size; written += block.length) {
+      fs.writeSync(fd, block, 0, Math.min(block.length, size - written));
+    }
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
+function hashStream(Cls, file) {
+  return new Promise((resolve, reject) => {
+    const h = new Cls(SEED);
+    fs.createReadStream(file)
+      .on('data', (chunk) => h.update(chunk))
+      .on('end', () => resolve(h.digest()))
+      .on('error', reject);
+  });
+}
+
+async function fileSweep() {
+  console.log('\n── File hashing throughput (warm page cache) ──');
+  const results = [];
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'xxhash-bench-'));
+
+  try {
+    for (const size of FILE_SIZES) {
+      const file = path.join(dir, `${size}.bin`);
+      writeTestFile(file, size);
+      console.log(`\n${sizeLabel(size)}:`);
+
+      for (const [name, Cls] of XXHASHERS) {
+        const modes = [
+          ['stream', async (n) => {
+            for (let i = 0; i < n; i++) await hashStream(Cls, file);
+          }],
+          ['hashFile', async (n) => {
+            for (let i = 0; i < n; i++) Cls.hashFile(file);
+          }],
+          ['hashFileAsync', async (n) => {
+            for (let i = 0; i < n; i++) await Cls.hashFileAsync(file);
+          }],
+        ];
+        for (const [mode, fn] of modes) {
+          const r = await measureAsync(`  ${name} ${mode}`, fn, size);
+          results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+        }
+      }
+      fs.unlinkSync(file);
+    }
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 5: Result allocation, Buffer vs. into/BigInt (GC pressure)
+// ═══════════════════════════════════════════
+// Runs run() and counts the GCs V8 performed meanwhile. gc entries are
+// delivered asynchronously and late, so they are matched by timestamp.
+async function withGcStats(run) {
+  const entries = [];
+  const observer = new PerformanceObserver((list) => entries.push(...list.getEntries()));
+  observer.observe({ entryTypes: ['gc'] });
+  const t0 = performance.now();
+  const result = run();
+  const t1 = performance.now();
+  await new Promise((resolve) => setTimeout(resolve, 0));
+  observer.disconnect();
+  const during = entries.filter((e) => e.startTime >= t0 && e.startTime <= t1);
+  return {
+    ...result,
+    gc_count: during.length,
+    gc_ms: round3(during.reduce((sum, e) => sum + e.duration, 0)),
+  };
+}
+
+async function resultSweep() {
+  console.log('\n── Result allocation (GC pressure) ──');
+  const results = [];
+
+  for (const size of RESULT_SIZES) {
+    const buf = Buffer.alloc(size);
+    crypto.randomFillSync(buf);
+    const out = Buffer.alloc(16);
+    console.log(`\n${sizeLabel(size)}:`);
+
+    for (const [name, Cls] of XXHASHERS) {
+      const h = new Cls(SEED);
+      h.update(buf);
+      const modes = [
+        ['hash', (n) => { for (let i = 0; i < n; i++) Cls.hash(buf); }],
+        ['hashInto', (n) => { for (let i = 0; i < n; i++) Cls.hashInto(buf, out); }],
+        ['hashBigInt', (n) => { for (let i = 0; i < n; i++) Cls.hashBigInt(buf); }],
+        ['digest', (n) => { for (let i = 0; i < n; i++) h.digest(); }],
+        ['digestInto', (n) => { for (let i = 0; i < n; i++) h.digestInto(out); }],
+        ['digestBigInt', (n) => { for (let i = 0; i < n; i++) h.digestBigInt(); }],
+      ];
+      for (const [mode, fn] of modes) {
+        const r = await withGcStats(() => measure(`  ${name} ${mode}`, fn, size));
+        console.log(`    ${r.gc_count} GCs, ${r.gc_ms} ms in GC`);
+        results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 6: String keys, hash(str) vs. hash(Buffer.from(str))
+// ═══════════════════════════════════════════
+function stringSweep() {
+  console.log('\n── String keys ──');
+  const results = [];
+
+  for (const size of KEY_SIZES) {
+    const key = crypto.randomBytes(size).toString('base64').slice(0, size);
+    console.log(`\n${sizeLabel(size)}:`);
+
+    for (const [name, Cls] of XXHASHERS) {
+      const modes = [
+        ['Buffer.from', (n) => { for (let i = 0; i < n; i++) Cls.hash(Buffer.from(key)); }],
+        ['string', (n) => { for (let i = 0; i < n; i++) Cls.hash(key); }],
+      ];
+      for (const [mode, fn] of modes) {
+        const r = measure(`  ${name} ${mode}`, fn, size);
+        results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 7: Seeded/secret one-shot, hash(data, key) vs. a throwaway hasher
+// ═══════════════════════════════════════════
+function seededSweep() {
+  console.log('\n── Seeded and secret one-shot ──');
+  const results = [];
+  const seed = 0x9e3779b1;
+  const seedBuf = Buffer.alloc(8);
+  seedBuf.writeUInt32BE(seed, 4);
+  const secretBuf = crypto.randomBytes(192);
+  const fromSeed = new XXH3Secret(seed);
+
+  for (const size of SEEDED_SIZES) {
+    const buf = buffers.get(size);
+    console.log(`\n${sizeLabel(size)}:`);
+
+    for (const [name, Cls] of XXHASHERS) {
+      const modes = [
+        ['hasher', (n) => {
+          for (let i = 0; i < n; i++) {
+            const h = new Cls(seedBuf);
+            h.update(buf);
+            h.digest();
+          }
+        }],
+        ['seed', (n) => { for (let i = 0; i < n; i++) Cls.hash(buf, seed); }],
+      ];
+      if (Cls !== XXHash64) {
+        modes.push(
+          ['secret', (n) => { for (let i = 0; i < n; i++) Cls.hash(buf, secretBuf); }],
+          ['XXH3Secret', (n) => { for (let i = 0; i < n; i++) Cls.hash(buf, fromSeed); }],
+        );
+      }
+      for (const [mode, fn] of modes) {
+        const r = measure(`  ${name} ${mode}`, fn, size);
+        results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 8: Shared prefix, clone()/cloneInto() of a primed hasher vs. re-hashing it
+// ═══════════════════════════════════════════
+function cloneSweep() {
+  console.log(`\n── Shared prefix + ${MESSAGE_SIZE} B message ──`);
+  const results = [];
+  const message = crypto.randomBytes(MESSAGE_SIZE);
+
+  for (const size of PREFIX_SIZES) {
+    const prefix = crypto.randomBytes(size);
+    console.log(`\n${sizeLabel(size)} prefix:`);
+
+    for (const [name, Cls] of XXHASHERS) {
+      const primed = new Cls(SEED);
+      primed.update(prefix);
+      const scratch = new Cls(SEED);
+      const modes = [
+        ['rehash', (n) => {
+          for (let i = 0; i < n; i++) {
+            const h = new Cls(SEED);
+            h.update(prefix);
+            h.update(message);
+            h.digest();
+          }
+        }],
+        ['clone', (n) => {
+          for (let i = 0; i < n; i++) {
+            const h = primed.clone();
+            h.update(message);
+            h.digest();
+          }
+        }],
+        ['cloneInto', (n) => {
+          for (let i = 0; i < n; i++) {
+            primed.cloneInto(scratch);
+            scratch.update(message);
+            scratch.digest();
+          }
+        }],
+      ];
+      for (const [mode, fn] of modes) {
+        const r = measure(`  ${name} ${mode}`, fn, size + MESSAGE_SIZE);
+        results.push({ name: `${name} ${mode}`, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 9: Columnar keys, hashColumns() vs. a per-row JS loop
+// ═══════════════════════════════════════════
+function columnSweep() {
+  console.log(`\n── Columnar hashing, ${COLUMN_ROWS} rows ──`);
+  const results = [];
+  const ids = new Int32Array(COLUMN_ROWS).map((_, i) => i);
+  const prices = new Float64Array(COLUMN_ROWS).map((_, i) => i / 7);
+  const big = new BigInt64Array(COLUMN_ROWS).map((_, i) => BigInt(i) * 1000003n);
+  const text = { data: Buffer.alloc(COLUMN_ROWS * 16), offsets: new Uint32Array(COLUMN_ROWS + 1) };
+  crypto.randomFillSync(text.data);
+  text.offsets.forEach((_, i) => { text.offsets[i] = i * 16; });
+
+  // Row key width in bytes (see the README for how keys are formed) and a
+  // JS loop that builds each row's key Buffer and hashes it.
+  const layouts = [
+    ['int32', 4, [ids], (key, i) => key.writeInt32LE(ids[i])],
+    ['int32+float64', 12, [ids, prices], (key, i) => {
+      key.writeInt32LE(ids[i]);
+      key.writeDoubleLE(prices[i], 4);
+    }],
+    ['int64+string', 28, [big, text], (key, i) => {
+      key.writeBigInt64LE(big[i]);
+      key.writeUInt32LE(16, 8);
+      text.data.copy(key, 12, i * 16, i * 16 + 16);
+    }],
+  ];
+
+  for (const [label, width, columns, fill] of layouts) {
+    console.log(`\n${label} (${width} B keys):`);
+    for (const [name, Cls] of XXHASHERS) {
+      const out = new BigUint64Array(COLUMN_ROWS * 2);
+      const modes = [
+        ['loop', (n) => {
+          for (let i = 0; i < n; i++) {
+            for (let j = 0; j < COLUMN_ROWS; j++) {
+              const key = Buffer.allocUnsafe(width);
+              fill(key, j);
+              Cls.hash(key);
+            }
+          }
+        }],
+        ['hashColumns', (n) => {
+          for (let i = 0; i < n; i++) Cls.hashColumns(columns, COLUMN_ROWS, 0, out);
+        }],
+      ];
+      for (const [mode, fn] of modes) {
+        const r = measure(`  ${name} ${mode}`, fn, width * COLUMN_ROWS);
+        results.push({ name: `${name} ${mode}`, size_bytes: width, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 10: Content-defined chunking, Chunker vs. a JS Gear scan + hash()
+// ═══════════════════════════════════════════
+function jsChunkAndHash(data, gearHi, gearLo) {
+  // FastCDC with the Chunker defaults (2/8/64 KB), Gear hash as uint32 halves.
+  const min = 2048, avg = 8192, max = 65536;
+  const maskS = 0xfffe0000, maskL = 0xffe00000;
+  for (let start = 0; start < data.length;) {
+    const end = Math.min(start + max, data.length);
+    let cut = end;
+    let hi = 0, lo = 0;
+    for (let i = start + min; i < end; i++) {
+      const sum = ((lo << 1) >>> 0) + gearLo[data[i]];
+      hi = (((hi << 1) | (lo >>> 31)) + gearHi[data[i]] + (sum > 0xffffffff ? 1 : 0)) >>> 0;
+      lo = sum >>> 0;
+      if ((hi & (i - start < avg ? maskS : maskL)) === 0) { cut = i + 1; break; }
+    }
+    XXHash128.hash(data.subarray(start, cut));
+    start = cut;
+  }
+}
+
+function chunkSweep() {
+  console.log('\n── Content-defined chunking throughput ──');
+  const results = [];
+  const gearHi = new Uint32Array(256);
+  const gearLo = new Uint32Array(256);
+  for (let b = 0; b < 256; b++) {
+    const g = XXHash64.hashBigInt(Buffer.from([b]));
+    gearHi[b] = Number(g >> 32n);
+    gearLo[b] = Number(g & 0xffffffffn);
+  }
+
+  for (const size of CHUNK_DATA_SIZES) {
+    const data = crypto.randomBytes(size);
+    console.log(`\n${sizeLabel(size)}:`);
+    const modes = [
+      ['JS FastCDC+XXH128', (n) => {
+        for (let i = 0; i < n; i++) jsChunkAndHash(data, gearHi, gearLo);
+      }],
+      ['Chunker XXH128', (n) => {
+        const chunker = new Chunker();
+        for (let i = 0; i < n; i++) { chunker.update(data); chunker.finish(); }
+      }],
+      ['Chunker XXH3', (n) => {
+        const chunker = new Chunker({ algorithm: 'xxh3' });
+        for (let i = 0; i < n; i++) { chunker.update(data); chunker.finish(); }
+      }],
+    ];
+    for (const [name, fn] of modes) {
+      const r = measure(`  ${name}`, fn, size);
+      results.push({ name, size_bytes: size, ...r });
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 11: Membership, XXH3HashSet/XXH3BloomFilter vs. JS Set and Bloom filter
+// ═══════════════════════════════════════════
+function jsBloomFilter(keyCount) {
+  // Textbook filter at 10 bits per key, 7 double-hashed bits per key.
+  const bits = keyCount * 10;
+  const words = new Uint32Array(Math.ceil(bits / 32));
+  const probe = (key, set) => {
+    const h = XXHash3.hashBigInt(key);
+    const h1 = Number(h & 0xffffffffn);
+    const h2 = Number(h >> 32n) | 1;
+    for (let i = 0; i < 7; i++) {
+      const pos = (h1 + i * h2) % bits;
+      if (set) words[pos >>> 5] |= 1 << (pos & 31);
+      else if ((words[pos >>> 5] & (1 << (pos & 31))) === 0) return false;
+    }
+    return true;
+  };
+  return { add: (key) => probe(key, true), has: (key) => probe(key, false) };
+}
+
+function membershipSweep() {
+  console.log(`\n── Membership, ${MEMBERSHIP_KEYS} keys added then looked up ──`);
+  const results = [];
+
+  for (const width of MEMBERSHIP_KEY_SIZES) {
+    const packed = crypto.randomBytes(MEMBERSHIP_KEYS * width);
+    const keys = Array.from({ length: MEMBERSHIP_KEYS }, (_, i) => packed.subarray(i * width, (i + 1) * width));
+    const strings = keys.map((key) => key.toString('latin1'));
+    console.log(`\n${width} B keys:`);
+    const modes = [
+      ['JS Set', (n) => {
+        for (let i = 0; i < n; i++) {
+          const set = new Set();
+          for (const key of strings) set.add(key);
+          for (const key of strings) set.has(key);
+        }
+      }],
+      ['XXH3HashSet', (n) => {
+        for (let i = 0; i < n; i++) {
+          const set = new XXH3HashSet();
+          set.addMany(packed, width);
+          set.hasMany(packed, width);
+        }
+      }],
+      ['JS Bloom', (n) => {
+        for (let i = 0; i < n; i++) {
+          const filter = jsBloomFilter(MEMBERSHIP_KEYS);
+          for (const key of keys) filter.add(key);
+          for (const key of keys) filter.has(key);
+        }
+      }],
+      ['XXH3BloomFilter', (n) => {
+        for (let i = 0; i < n; i++) {
+          const filter = new XXH3BloomFilter(MEMBERSHIP_KEYS, 0.01);
+          filter.addMany(packed, width);
+          filter.hasMany(packed, width);
+        }
+      }],
+    ];
+    for (const [name, fn] of modes) {
+      const r = measure(`  ${name}`, fn, 2 * packed.length);
+      results.push({ name, size_bytes: width, ...r });
+    }
+  }
+
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Part 12: XXH3 throughput per SIMD backend
+// ═══════════════════════════════════════════
+function simdSweep() {
+  const backends = listSimdBackends();
+  const initial = getSimdBackend();
+  console.log(`\n── SIMD backends (${backends.join(', ')}; default ${initial}) ──`);
+  const results = [];
+
+  for (const size of SIMD_SIZES) {
+    const buf = buffers.get(size);
+    console.log(`\n${sizeLabel(size)}:`);
+
+    for (const backend of backends) {
+      setSimdBackend(backend);
+      const oneshot = measure(`  ${backend} XXH3`, (n) => {
+        for (let i = 0; i < n; i++) XXHash3.hash(buf);
+      }, size);
+      results.push({ name: `${backend} XXH3`, size_bytes: size, ...oneshot });
+
+      const h = new XXHash3(SEED);
+      const streaming = measure(`  ${backend} XXH3 stream`, (n) => {
+        h.reset();
+        for (let i = 0; i < n; i++) h.update(buf);
+        h.digest();
+      }, size);
+      results.push({ name: `${backend} XXH3 stream`, size_bytes: size, ...streaming });
+    }
+  }
+
+  setSimdBackend(initial);
+  return results;
+}
+
+// ═══════════════════════════════════════════
+// Latency mode (--latency): ns/call on small inputs vs. a native loop
+// ═══════════════════════════════════════════
+// "native" rows make the same xxHash calls from one C loop (_nativeHashLoop),
+// so overhead_ns on the other rows is what the binding adds per call: N-API
+// dispatch, argument and `this` unwrapping, and the result allocation.
+function latencySweep() {
+  console.log('\n── Small-input latency ──');
+  const results = [];
+  const classes = [['XXH32', XXHash32], ['XXH64', XXHash64], ['XXH3', XXHash3], ['XXH128', XXHash128]];
+
+  for (const size of LATENCY_SIZES) {
+    const buf = crypto.randomBytes(size);
+    console.log(`\n${sizeLabel(size)}:`);
+
+    for (const [name, Cls] of classes) {
+      const h = new Cls(Buffer.alloc(name === 'XXH32' ? 4 : 8));
+      const value = name === 'XXH32' ? 'hashNumber' : 'hashBigInt';
+      const modes = [
+        [`${name} native`, true, (n) => _nativeHashLoop(name, buf, n)],
+        [`${name} hash()`, false, (n) => {
+          for (let i = 0; i < n; i++) Cls.hash(buf);
+        }],
+        [`${name} ${value}()`, false, (n) => {
+          for (let i = 0; i < n; i++) Cls[value](buf);
+        }],
+        [`${name} native stream`, true, (n) => _nativeHashLoop(name, buf, n, true)],
+        [`${name} update()+digest()`, false, (n) => {
+          for (let i = 0; i < n; i++) {
+            h.reset();
+            h.update(buf);
+            h.digest();
+          }
+        }],
+      ];
+      let native;
+      for (const [label, isNative, fn] of modes) {
+        const r = measureLatency(`  ${label}`, fn);
+        if (isNative) native = r.median_ns;
+        else r.overhead_ns = round3(r.median_ns - native);
+        results.push({ name: label, size_bytes: size, ...r });
+      }
+    }
+  }
+
+  return results;
+}
+
 // ── Collect metadata ──
 function collectMetadata() {
   const cpus = os.cpus();
@@ -177,8 +811,27 @@ function collectMetadata() {
     nodeVersion: process.version,
     v8Version: process.versions.v8,
     compiler: process.env.BENCHMARK_COMPILER || 'unknown',
+    mode: LATENCY_MODE ? 'latency' : 'throughput',
     xxhashVersion: '0.8.3',
     sizes: SIZES,
+    recordSizes: RECORD_SIZES,
+    batchRecords: BATCH_RECORDS,
+    fileSizes: FILE_SIZES,
+    resultSizes: RESULT_SIZES,
+    keySizes: KEY_SIZES,
+    seededSizes: SEEDED_SIZES,
+    prefixSizes: PREFIX_SIZES,
+    messageSize: MESSAGE_SIZE,
+    columnRows: COLUMN_ROWS,
+    chunkDataSizes: CHUNK_DATA_SIZES,
+    membershipKeys: MEMBERSHIP_KEYS,
+    membershipKeySizes: MEMBERSHIP_KEY_SIZES,
+    simdSizes: SIMD_SIZES,
+    simdBackend: getSimdBackend(),
+    simdBackends: listSimdBackends(),
+    latencySizes: LATENCY_SIZES,
+    latencyTargetMs: LATENCY_TARGET_MS,
+    statsEnabled: getStats().enabled,
     targetMs: TARGET_MS,
     warmupRuns: WARMUP,
     measuredRuns: RUNS,
@@ -189,18 +842,18 @@ function collectMetadata() {
 }
 
 // ── Print summary table ──
-function printSweepTable(title, results) {
+function printSweepTable(title, results, names = ALL_NAMES, sizes = SIZES) {
   console.log(`\n${title}`);
-  const nameW = 8;
+  const nameW = Math.max(8, ...names.map(n => n.length + 1));
   const colW = 8;
   let header = 'Hash'.padEnd(nameW);
-  for (const s of SIZES) header += sizeLabel(s).padStart(colW);
+  for (const s of sizes) header += sizeLabel(s).padStart(colW);
   console.log(header);
   console.log('-'.repeat(header.length));
 
-  for (const name of ALL_NAMES) {
+  for (const name of names) {
     let row = name.padEnd(nameW);
-    for (const s of SIZES) {
+    for (const s of sizes) {
       const r = results.find(x => x.name === name && x.size_bytes === s);
       row += (r ? r.median_gbps.toFixed(2) : '-').padStart(colW);
     }
@@ -208,17 +861,102 @@ function printSweepTable(title, results) {
   }
 }
 
+function printLatencyTable(results) {
+  console.log('\n=== Small-input Latency (ns/call; overhead over native in brackets) ===');
+  const names = [...new Set(results.map(r => r.name))];
+  const nameW = Math.max(8, ...names.map(n => n.length + 1));
+  const colW = 17;
+  let header = 'Call'.padEnd(nameW);
+  for (const s of LATENCY_SIZES) header += sizeLabel(s).padStart(colW);
+  console.log(header);
+  console.log('-'.repeat(header.length));
+
+  for (const name of names) {
+    let row = name.padEnd(nameW);
+    for (const s of LATENCY_SIZES) {
+      const r = results.find(x => x.name === name && x.size_bytes === s);
+      const cell = !r ? '-' : r.overhead_ns === undefined
+        ? r.median_ns.toFixed(1)
+        : `${r.median_ns.toFixed(1)} (${r.overhead_ns.toFixed(1)})`;
+      row += cell.padStart(colW);
+    }
+    console.log(row);
+  }
+}
+
+// ── Compare against a stored run (BENCHMARK_BASELINE) ──
+// Rows are matched by section, name and size. A row regresses when it is
+// more than MAX_REGRESSION slower: higher ns/call, or lower GB/s.
+function checkRegressions(output) {
+  const baseline = JSON.parse(fs.readFileSync(process.env.BENCHMARK_BASELINE, 'utf8'));
+  const regressions = [];
+
+  for (const [section, rows] of Object.entries(output)) {
+    if (section === 'headline' || !Array.isArray(rows) || !Array.isArray(baseline[section])) continue;
+    for (const r of rows) {
+      const b = baseline[section].find(x => x.name === r.name && x.size_bytes === r.size_bytes);
+      if (!b) continue;
+      const slowdown = r.median_ns !== undefined
+        ? r.median_ns / b.median_ns - 1
+        : b.median_gbps / r.median_gbps - 1;
+      if (slowdown > MAX_REGRESSION) {
+        regressions.push(`${section}: ${r.name} @ ${sizeLabel(r.size_bytes)} is ${(slowdown * 100).toFixed(1)}% slower`);
+      }
+    }
+  }
+
+  console.log(`\n=== Regressions over ${(MAX_REGRESSION * 100).toFixed(0)}% vs. ${process.env.BENCHMARK_BASELINE} ===`);
+  for (const line of regressions) console.log(`  ${line}`);
+  if (regressions.length === 0) console.log('  none');
+  else process.exitCode = 1;
+}
+
+function report(output) {
+  const jsonStr = JSON.stringify(output, null, 2);
+
+  if (process.env.BENCHMARK_OUTPUT) {
+    fs.writeFileSync(process.env.BENCHMARK_OUTPUT, jsonStr, 'utf8');
+    console.log(`\nJSON written to ${process.env.BENCHMARK_OUTPUT}`);
+  }
+
+  console.log('\n--- JSON_START ---');
+  console.log(jsonStr);
+  console.log('--- JSON_END ---');
+
+  if (process.env.BENCHMARK_BASELINE) checkRegressions(output);
+}
+
 // ── Main ──
-function main() {
+async function main() {
   const metadata = collectMetadata();
 
   console.log('=== xxhash-addon Benchmark ===');
   console.log(`Platform: ${metadata.os} ${metadata.arch} | CPU: ${metadata.cpuModel}`);
-  console.log(`Node: ${metadata.nodeVersion} | Compiler: ${metadata.compiler}`);
-  console.log(`Target: ~${TARGET_MS}ms/run | ${WARMUP} warmup + ${RUNS} measured runs`);
+  console.log(`Node: ${metadata.nodeVersion} | Compiler: ${metadata.compiler} | SIMD: ${metadata.simdBackend}`);
+  if (metadata.statsEnabled) {
+    console.log('Call statistics are on (XXHASH_ADDON_STATS): results include their cost');
+  }
+  console.log(`Target: ~${LATENCY_MODE ? LATENCY_TARGET_MS : TARGET_MS}ms/run | ${WARMUP} warmup + ${RUNS} measured runs`);
+
+  if (LATENCY_MODE) {
+    const latency = latencySweep();
+    printLatencyTable(latency);
+    report({ metadata, latency });
+    return;
+  }
 
   const streaming = streamingSweep();
   const oneshot = oneshotSweep();
+  const batch = batchSweep();
+  const files = await fileSweep();
+  const results = await resultSweep();
+  const strings = stringSweep();
+  const seeded = seededSweep();
+  const clones = cloneSweep();
+  const columns = columnSweep();
+  const chunks = chunkSweep();
+  const membership = membershipSweep();
+  const simd = simdSweep();
 
   // Extract headline from streaming at HEADLINE_CHUNK size
   const headline = streaming
@@ -230,6 +968,26 @@ function main() {
   // ── Summary tables ──
   printSweepTable('=== Streaming Throughput (GB/s) ===', streaming);
   printSweepTable('=== One-shot Throughput (GB/s) ===', oneshot);
+  printSweepTable('=== Batch Throughput by Record Size (GB/s) ===', batch,
+    [...new Set(batch.map(r => r.name))], RECORD_SIZES);
+  printSweepTable('=== File Hashing Throughput (GB/s) ===', files,
+    [...new Set(files.map(r => r.name))], FILE_SIZES);
+  printSweepTable('=== Result Allocation Throughput (GB/s) ===', results,
+    [...new Set(results.map(r => r.name))], RESULT_SIZES);
+  printSweepTable('=== String Key Throughput (GB/s) ===', strings,
+    [...new Set(strings.map(r => r.name))], KEY_SIZES);
+  printSweepTable('=== Seeded One-shot Throughput (GB/s) ===', seeded,
+    [...new Set(seeded.map(r => r.name))], SEEDED_SIZES);
+  printSweepTable('=== Shared Prefix Throughput by Prefix Size (GB/s) ===', clones,
+    [...new Set(clones.map(r => r.name))], PREFIX_SIZES);
+  printSweepTable('=== Columnar Throughput by Row Key Width (GB/s) ===', columns,
+    [...new Set(columns.map(r => r.name))], [...new Set(columns.map(r => r.size_bytes))]);
+  printSweepTable('=== Content-Defined Chunking Throughput (GB/s) ===', chunks,
+    [...new Set(chunks.map(r => r.name))], CHUNK_DATA_SIZES);
+  printSweepTable('=== Membership Throughput by Key Size (GB/s) ===', membership,
+    [...new Set(membership.map(r => r.name))], MEMBERSHIP_KEY_SIZES);
+  printSweepTable('=== XXH3 Throughput by SIMD Backend (GB/s) ===', simd,
+    [...new Set(simd.map(r => r.name))], SIMD_SIZES);
 
   console.log('\n=== Headline: Streaming @ 64 KB chunks (GB/s) ===');
   for (const r of headline) {
@@ -237,17 +995,10 @@ function main() {
   }
 
   // ── JSON output ──
-  const output = { metadata, streaming, oneshot, headline };
-  const jsonStr = JSON.stringify(output, null, 2);
-
-  if (process.env.BENCHMARK_OUTPUT) {
-    fs.writeFileSync(process.env.BENCHMARK_OUTPUT, jsonStr, 'utf8');
-    console.log(`\nJSON written to ${process.env.BENCHMARK_OUTPUT}`);
-  }
-
-  console.log('\n--- JSON_START ---');
-  console.log(jsonStr);
-  console.log('--- JSON_END ---');
+  report({ metadata, streaming, oneshot, batch, files, results, strings, seeded, clones, columns, chunks, membership, simd, headline });
 }
 
-main();
+main().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
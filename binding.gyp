@@ -4,25 +4,43 @@
       "xxHash",
       "src"
     ],
-    "sources": [
-      "src/addon.c",
-      "src/xxhash128_addon.c",
-      "src/xxhash3_addon.c",
-      "src/xxhash64_addon.c",
-      "src/xxhash32_addon.c",
-      "xxHash/xxhash.c"
-    ],
-    # "defines": [ "ENABLE_RUNTIME_TYPE_CHECK" ]
+    # N-API 8 (Node >= 14.17) for napi_type_tag_object().
+    "defines": [ "NAPI_VERSION=8" ]
+    # Add "ENABLE_RUNTIME_TYPE_CHECK" to check constructor seeds.
   },
   "targets": [
     {
       "target_name": "addon",
+      "sources": [
+        "src/addon.c",
+        "src/xxhash128_addon.c",
+        "src/xxhash3_addon.c",
+        "src/xxhash64_addon.c",
+        "src/xxhash32_addon.c",
+        "src/xxh3secret_addon.c",
+        "src/chunker_addon.c",
+        "src/bloom_addon.c",
+        "src/hashset_addon.c",
+        "src/util.c",
+        "src/file.c",
+        "src/parallel.c",
+        "src/pool.c",
+        "src/state.c",
+        "src/columns.c",
+        "src/baseline.c",
+        "src/stats.c",
+        "src/simd.c",
+        "src/simd_scalar.c",
+        "src/simd_x86.c",
+        "src/simd_neon.c",
+        "xxHash/xxhash.c"
+      ],
       "conditions": [
         [
-          "target_arch=='x64' or target_arch=='ia32'",
+          "OS=='linux' and target_arch=='arm64'",
           {
-            "sources": ["xxHash/xxh_x86dispatch.c"],
-            "defines": ["XXHASH_DISPATCH=1"]
+            "dependencies": ["simd_sve"],
+            "defines": ["SIMD_SVE=1"]
           }
         ],
         [
@@ -103,6 +121,27 @@
         ]
       ]
     }
+  ],
+  "conditions": [
+    [
+      # SVE kernels need SVE enabled for their whole translation unit.
+      "OS=='linux' and target_arch=='arm64'",
+      {
+        "targets": [
+          {
+            "target_name": "simd_sve",
+            "type": "static_library",
+            "sources": ["src/simd_sve.c"],
+            "defines": ["SIMD_SVE=1", "XXH3_STREAM_USE_STACK=1"],
+            "cflags": [
+              "-O3",
+              "-std=c99",
+              "-fPIC",
+              "-march=armv8-a+sve",
+            ]
+          }
+        ]
+      }
+    ]
   ]
 }
-
@@ -1,37 +1,317 @@
+/**
+ * Data accepted by the hashing methods. Strings are hashed as their UTF-8
+ * bytes; views are hashed over their byte range, with no copy.
+ */
+export type HashInput = string | ArrayBufferView | ArrayBuffer;
+
+/**
+ * Seed for one-shot hashing: a number (safe integer) or bigint, or a 4- or
+ * 8-byte Buffer holding it in canonical (big-endian) form as the
+ * constructors take it. XXHash32 seeds are 32-bit.
+ */
+export type Seed = number | bigint | Uint8Array;
+
+/**
+ * XXHash3/XXHash128 also take a secret: a Buffer of at least 136 bytes, used
+ * in place, or a precomputed XXH3Secret.
+ */
+export type SeedOrSecret = Seed | XXH3Secret;
+
 export interface XXHash {
-  update(data: Buffer): void;
+  update(data: HashInput): void;
   digest(): Buffer;
+  /** Writes the canonical digest at out[offset]; returns offset + digest size. */
+  digestInto(out: Uint8Array, offset?: number): number;
   reset(): void;
+  /** A new hasher of the same class, in the same state (seed, secret, data so far). */
+  clone(): this;
+  /** Copies this hasher's state into target, an existing hasher of the same class. */
+  cloneInto(target: this): void;
+  /** Serializes the streaming state, seed or secret included, for importState(). */
+  exportState(): Buffer;
+  updateAsync(data: HashInput): Promise<void>;
+  digestAsync(): Promise<Buffer>;
+}
+
+/**
+ * Record boundaries for `hashBatch(data, offsets)`: record `i` spans
+ * `data[offsets[i], offsets[i + 1])`, so `offsets.length` is one more than
+ * the number of records.
+ */
+export type BatchOffsets = Uint32Array;
+
+/**
+ * A column for `hashColumns()`: a TypedArray of fixed-width values, or
+ * variable-width values (e.g. UTF-8 strings) packed into `data`, where row
+ * `i` spans `data[offsets[i], offsets[i + 1])`.
+ */
+export type HashColumn =
+  | Exclude<ArrayBufferView, DataView>
+  | { data: ArrayBufferView; offsets: Uint32Array };
+
+export interface ParallelOptions {
+  /** Bytes per leaf chunk, >= 1024. Part of the format. Default 1 MiB. */
+  chunkSize?: number;
+  /**
+   * Threads, calling thread included. Default: CPU count. Workers persist
+   * between calls; the call blocks until the whole input is hashed.
+   */
+  threads?: number;
 }
 
 export class XXHash32 implements XXHash {
   constructor(seed: Buffer);
-  update(data: Buffer): void;
+  update(data: HashInput): void;
   digest(): Buffer;
+  digestInto(out: Uint8Array, offset?: number): number;
+  digestNumber(): number;
   reset(): void;
-  static hash(data: Buffer): Buffer;
+  clone(): XXHash32;
+  cloneInto(target: XXHash32): void;
+  exportState(): Buffer;
+  updateAsync(data: HashInput): Promise<void>;
+  digestAsync(): Promise<Buffer>;
+  static hash(data: HashInput, seed?: Seed): Buffer;
+  static hashInto(data: HashInput, out: Uint8Array, offset?: number): number;
+  static hashNumber(data: HashInput, seed?: Seed): number;
+  static hashAsync(data: HashInput): Promise<Buffer>;
+  /** Resumes a hasher from exportState(); throws on a damaged state or one from another class. */
+  static importState(state: Uint8Array): XXHash32;
+  static hashFile(path: string, offset?: number, length?: number): Buffer;
+  static hashFileAsync(path: string, offset?: number, length?: number): Promise<Buffer>;
+  static hashBatch(data: HashInput[]): Buffer;
+  static hashBatch<T extends Buffer | Uint32Array>(data: HashInput[], out: T): T;
+  static hashBatch(data: HashInput, offsets: BatchOffsets): Buffer;
+  static hashBatch<T extends Buffer | Uint32Array>(data: HashInput, offsets: BatchOffsets, out: T): T;
+  /** One hash per row of the columns, each row's values combined natively; see README. */
+  static hashColumns(columns: HashColumn[], rowCount: number, seed?: Seed): Uint32Array;
+  static hashColumns<T extends Buffer | Uint32Array>(columns: HashColumn[], rowCount: number, seed: Seed, out: T): T;
 }
 
 export class XXHash64 implements XXHash {
   constructor(seed: Buffer);
-  update(data: Buffer): void;
+  update(data: HashInput): void;
   digest(): Buffer;
+  digestInto(out: Uint8Array, offset?: number): number;
+  digestBigInt(): bigint;
   reset(): void;
-  static hash(data: Buffer): Buffer;
+  clone(): XXHash64;
+  cloneInto(target: XXHash64): void;
+  exportState(): Buffer;
+  updateAsync(data: HashInput): Promise<void>;
+  digestAsync(): Promise<Buffer>;
+  static hash(data: HashInput, seed?: Seed): Buffer;
+  static hashInto(data: HashInput, out: Uint8Array, offset?: number): number;
+  static hashBigInt(data: HashInput, seed?: Seed): bigint;
+  static hashAsync(data: HashInput): Promise<Buffer>;
+  /** Resumes a hasher from exportState(); throws on a damaged state or one from another class. */
+  static importState(state: Uint8Array): XXHash64;
+  static hashFile(path: string, offset?: number, length?: number): Buffer;
+  static hashFileAsync(path: string, offset?: number, length?: number): Promise<Buffer>;
+  static hashBatch(data: HashInput[]): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput[], out: T): T;
+  static hashBatch(data: HashInput, offsets: BatchOffsets): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput, offsets: BatchOffsets, out: T): T;
+  static hashColumns(columns: HashColumn[], rowCount: number, seed?: Seed): BigUint64Array;
+  static hashColumns<T extends Buffer | BigUint64Array>(columns: HashColumn[], rowCount: number, seed: Seed, out: T): T;
 }
 
 export class XXHash3 implements XXHash {
   constructor(seed_or_secret: Buffer);
-  update(data: Buffer): void;
+  update(data: HashInput): void;
   digest(): Buffer;
+  digestInto(out: Uint8Array, offset?: number): number;
+  digestBigInt(): bigint;
   reset(): void;
-  static hash(data: Buffer): Buffer;
+  clone(): XXHash3;
+  cloneInto(target: XXHash3): void;
+  exportState(): Buffer;
+  updateAsync(data: HashInput): Promise<void>;
+  digestAsync(): Promise<Buffer>;
+  static hash(data: HashInput, seedOrSecret?: SeedOrSecret): Buffer;
+  static hashInto(data: HashInput, out: Uint8Array, offset?: number): number;
+  static hashBigInt(data: HashInput, seedOrSecret?: SeedOrSecret): bigint;
+  static hashAsync(data: HashInput): Promise<Buffer>;
+  /** Resumes a hasher from exportState(); throws on a damaged state or one from another class. */
+  static importState(state: Uint8Array): XXHash3;
+  static hashFile(path: string, offset?: number, length?: number): Buffer;
+  static hashFileAsync(path: string, offset?: number, length?: number): Promise<Buffer>;
+  static hashParallel(data: HashInput, options?: ParallelOptions): Buffer;
+  static hashBatch(data: HashInput[]): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput[], out: T): T;
+  static hashBatch(data: HashInput, offsets: BatchOffsets): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput, offsets: BatchOffsets, out: T): T;
+  static hashColumns(columns: HashColumn[], rowCount: number, seedOrSecret?: SeedOrSecret): BigUint64Array;
+  static hashColumns<T extends Buffer | BigUint64Array>(columns: HashColumn[], rowCount: number, seedOrSecret: SeedOrSecret, out: T): T;
 }
 
 export class XXHash128 implements XXHash {
   constructor(seed_or_secret: Buffer);
-  update(data: Buffer): void;
+  update(data: HashInput): void;
   digest(): Buffer;
+  digestInto(out: Uint8Array, offset?: number): number;
+  digestBigInt(): bigint;
   reset(): void;
-  static hash(data: Buffer): Buffer;
+  clone(): XXHash128;
+  cloneInto(target: XXHash128): void;
+  exportState(): Buffer;
+  updateAsync(data: HashInput): Promise<void>;
+  digestAsync(): Promise<Buffer>;
+  static hash(data: HashInput, seedOrSecret?: SeedOrSecret): Buffer;
+  static hashInto(data: HashInput, out: Uint8Array, offset?: number): number;
+  static hashBigInt(data: HashInput, seedOrSecret?: SeedOrSecret): bigint;
+  static hashAsync(data: HashInput): Promise<Buffer>;
+  /** Resumes a hasher from exportState(); throws on a damaged state or one from another class. */
+  static importState(state: Uint8Array): XXHash128;
+  static hashFile(path: string, offset?: number, length?: number): Buffer;
+  static hashFileAsync(path: string, offset?: number, length?: number): Promise<Buffer>;
+  static hashParallel(data: HashInput, options?: ParallelOptions): Buffer;
+  static hashBatch(data: HashInput[]): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput[], out: T): T;
+  static hashBatch(data: HashInput, offsets: BatchOffsets): Buffer;
+  static hashBatch<T extends Buffer | BigUint64Array>(data: HashInput, offsets: BatchOffsets, out: T): T;
+  /** Two lanes per row: high64, low64. */
+  static hashColumns(columns: HashColumn[], rowCount: number, seedOrSecret?: SeedOrSecret): BigUint64Array;
+  static hashColumns<T extends Buffer | BigUint64Array>(columns: HashColumn[], rowCount: number, seedOrSecret: SeedOrSecret, out: T): T;
 }
+
+/**
+ * A precomputed XXH3 secret for XXHash3.hash()/XXHash128.hash(), held
+ * natively so it is not copied on every call. From a number or bigint it is
+ * derived from that seed and hashes exactly like it; from any other input it
+ * is generated from that entropy, `size` bytes long (default 192, min 136).
+ */
+export class XXH3Secret {
+  constructor(seedOrEntropy: number | bigint | HashInput, size?: number);
+  readonly size: number;
+  /** A copy of the secret bytes, e.g. for `new XXHash3(secret.toBuffer())`. */
+  toBuffer(): Buffer;
+}
+
+export interface ChunkerOptions {
+  /** No chunk (but the last) is shorter. Default 2 KiB, at least 64. */
+  minSize?: number;
+  /** Target average chunk size. Default 8 KiB, at least 256. */
+  avgSize?: number;
+  /** No chunk is longer. Default 64 KiB, at most 2^30. */
+  maxSize?: number;
+  /** Per-chunk digest: XXH3 64-bit or XXH128 (default). */
+  algorithm?: 'xxh3' | 'xxh128';
+  /** Seed for the digests; boundaries do not depend on it. */
+  seed?: number | bigint;
+}
+
+/**
+ * Chunks finished by one call, as packed arrays: chunk `i` starts at stream
+ * offset `offsets[i]`, is `lengths[i]` bytes long, and has the canonical
+ * digest at `digests[i * size, (i + 1) * size)`, size being 8 or 16.
+ */
+export interface ChunkBatch {
+  offsets: Float64Array;
+  lengths: Uint32Array;
+  digests: Buffer;
+}
+
+/** Content-defined (FastCDC) chunking with a digest per chunk. */
+export class Chunker {
+  constructor(options?: ChunkerOptions);
+  update(data: HashInput): ChunkBatch;
+  /** Emits the last chunk and starts a new stream at offset 0. */
+  finish(): ChunkBatch;
+}
+
+/**
+ * Keys for `addMany()`/`hasMany()`: an array of inputs, or one buffer split
+ * by `BatchOffsets` or, for fixed-width keys, by a key width in bytes.
+ */
+export type KeyLayout = BatchOffsets | number;
+
+/**
+ * A blocked Bloom filter over XXH3 64-bit hashes, stored natively in
+ * cache-line blocks. Sized for `falsePositiveRate` (default 0.01) at
+ * `expectedItems` keys.
+ */
+export class XXH3BloomFilter {
+  constructor(expectedItems: number, falsePositiveRate?: number, seed?: number | bigint);
+  /** True when `key` was surely not in the filter before. */
+  add(key: HashInput): boolean;
+  /** False when `key` was never added; true otherwise, or falsely. */
+  has(key: HashInput): boolean;
+  /** One `add()` result per key, as 1 or 0. */
+  addMany(keys: HashInput[]): Uint8Array;
+  addMany(keys: ArrayBufferView, layout: KeyLayout): Uint8Array;
+  /** One `has()` result per key, as 1 or 0. */
+  hasMany(keys: HashInput[]): Uint8Array;
+  hasMany(keys: ArrayBufferView, layout: KeyLayout): Uint8Array;
+  exportState(): Buffer;
+  static importState(state: HashInput): XXH3BloomFilter;
+}
+
+/**
+ * A set of the XXH3 64-bit hashes of its keys (keys with equal hashes count
+ * as one), stored natively in cache-line buckets; it grows as needed.
+ */
+export class XXH3HashSet {
+  constructor(expectedItems?: number, seed?: number | bigint);
+  readonly size: number;
+  /** True when `key` was new to the set. */
+  add(key: HashInput): boolean;
+  has(key: HashInput): boolean;
+  /** One `add()` result per key, as 1 or 0. */
+  addMany(keys: HashInput[]): Uint8Array;
+  addMany(keys: ArrayBufferView, layout: KeyLayout): Uint8Array;
+  /** One `has()` result per key, as 1 or 0. */
+  hasMany(keys: HashInput[]): Uint8Array;
+  hasMany(keys: ArrayBufferView, layout: KeyLayout): Uint8Array;
+  exportState(): Buffer;
+  static importState(state: HashInput): XXH3HashSet;
+}
+
+/**
+ * The SIMD backend that XXH3 and XXH128 use for inputs over 240 bytes and
+ * for streaming: 'scalar', 'sse2', 'avx2', 'avx512', 'neon', 'sve', or
+ * 'default' (the kernel the addon was compiled with) elsewhere. Defaults to
+ * the fastest one the CPU supports, or to the XXHASH_ADDON_SIMD environment
+ * variable when it names a supported one.
+ */
+export type SimdBackend = 'scalar' | 'sse2' | 'avx2' | 'avx512' | 'neon' | 'sve' | 'default';
+
+export function getSimdBackend(): SimdBackend;
+/**
+ * Switches the process-wide backend; 'auto' picks the fastest. Throws a
+ * RangeError for a backend this CPU or build does not have. Hashes do not
+ * depend on the backend.
+ */
+export function setSimdBackend(backend: SimdBackend | 'auto'): SimdBackend;
+/** The backends this CPU and build support, slowest first. */
+export function listSimdBackends(): SimdBackend[];
+
+/** Counters of one operation of one class; see getStats(). */
+export interface OpStats {
+  calls: number;
+  /** Input bytes; always 0 for digest. */
+  bytes: number;
+  /** 33 log2 buckets: [0] empty inputs, [i] 2^(i-1) to 2^i - 1 bytes. */
+  sizes: number[];
+  /** 32 log2 buckets of sampled call durations in ns. */
+  latencyNs: number[];
+}
+
+export interface Stats {
+  enabled: boolean;
+  /** One call in sampleEvery is timed; 0 when none is. */
+  sampleEvery: number;
+  classes: Record<'XXH32' | 'XXH64' | 'XXH3' | 'XXH128', { hash: OpStats; update: OpStats; digest: OpStats }>;
+}
+
+/**
+ * Process-wide call statistics of hash(), update(), digest() and their
+ * Into/Number/BigInt variants. Off unless enableStats() was called or the
+ * XXHASH_ADDON_STATS environment variable was set at load time (a number N
+ * also times one call in N).
+ */
+export function getStats(): Stats;
+export function resetStats(): void;
+/** Leaves the sampling interval as it is when sampleEvery is not given. */
+export function enableStats(sampleEvery?: number): void;
+export function disableStats(): void;
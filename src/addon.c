@@ -5,6 +5,13 @@ static napi_value init_all(napi_env env, napi_value exports) {
    CALL_INIT(XXHash3)
    CALL_INIT(XXHash64)
    CALL_INIT(XXHash32)
+   CALL_INIT(XXH3Secret)
+   CALL_INIT(Chunker)
+   CALL_INIT(XXH3BloomFilter)
+   CALL_INIT(XXH3HashSet)
+   CALL_INIT(Baseline)
+   CALL_INIT(Stats)
+   CALL_INIT(Simd)
    return exports;
 }
 
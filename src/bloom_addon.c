@@ -0,0 +1,371 @@
+#include "xxhash_addon.h"
+
+#include <math.h>
+
+/* A blocked Bloom filter (Putze et al., 2007): the high 32 bits of a key's
+ * XXH3_64bits_withSeed() pick one 512-bit block, a cache line, and all of
+ * the key's hashes_ bits are set in that block, so a lookup touches one
+ * line however many bits it tests. The bit positions are the top 9 bits of
+ * the hash times successive powers of BLOOM_MIX; double hashing, cheaper
+ * still, leaves too few distinct patterns in a 512-bit block and with them
+ * a floor under the false positive rate.
+ * Blocking costs accuracy against a textbook filter of the same size, as
+ * keys crowd into some blocks more than others, so the filter is sized with
+ * the rate of the blocked layout itself (see blocked_rate()). */
+#define BLOOM_BLOCK_WORDS (CACHE_LINE_SIZE / 8)
+#define BLOOM_MAX_HASHES 16
+#define BLOOM_MAX_BLOCKS ((uint64_t)1 << 32)
+#define BLOOM_MIX 0x9E3779B97F4A7C15ULL
+#define BLOOM_DEFAULT_RATE 0.01
+#define BLOOM_LN2 0.69314718055994530942
+
+/* Exported payload: seed u64 | hashes u32 | blocks u64 | the bit array as
+ * u64 words, block after block. */
+#define BLOOM_STATE_FIELDS (8 + 4 + 8)
+
+static uint64_t *block_of(const XXH3BloomFilter_Wrapper_t *f,
+                          XXH64_hash_t h) {
+   return f->bits_ + ((h >> 32) * f->blocks_ >> 32) * BLOOM_BLOCK_WORDS;
+}
+
+/* Sets the bits of h; returns whether any of them was clear, that is
+ * whether h was surely not in the filter before. */
+static int bloom_add(XXH3BloomFilter_Wrapper_t *f, XXH64_hash_t h) {
+   uint64_t *block = block_of(f, h);
+   uint64_t missing = 0;
+   uint64_t bit;
+   uint32_t pos;
+   uint32_t i;
+
+   for (i = 0; i < f->hashes_; i++) {
+      h *= BLOOM_MIX;
+      pos = (uint32_t)(h >> 55);
+      bit = (uint64_t)1 << (pos & 63);
+      missing |= ~block[pos >> 6] & bit;
+      block[pos >> 6] |= bit;
+   }
+   return missing != 0;
+}
+
+static int bloom_has(const XXH3BloomFilter_Wrapper_t *f, XXH64_hash_t h) {
+   const uint64_t *block = block_of(f, h);
+   uint32_t pos;
+   uint32_t i;
+
+   for (i = 0; i < f->hashes_; i++) {
+      h *= BLOOM_MIX;
+      pos = (uint32_t)(h >> 55);
+      if ((block[pos >> 6] & (uint64_t)1 << (pos & 63)) == 0) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/* The false positive rate of blocks blocks holding items keys that set
+ * hashes bits each: a block's key count j is Poisson distributed around
+ * items / blocks, and a block of j keys answers yes with probability
+ * (1 - (1 - 1/512)^(j hashes))^hashes. Terms beyond ten standard
+ * deviations are negligible. */
+static double blocked_rate(double items, double blocks, double hashes) {
+   const double bits = BLOOM_BLOCK_WORDS * 64;
+   double mean = items / blocks;
+   double spread = 10 * sqrt(mean) + 10;
+   double j = floor(mean - spread);
+   double rate = 0;
+
+   for (j = j < 0 ? 0 : j; j <= mean + spread; j++) {
+      rate += exp(j * log(mean) - mean - lgamma(j + 1)) *
+              pow(1 - pow(1 - 1 / bits, j * hashes), hashes);
+   }
+   return rate;
+}
+
+/* Allocates a wrapper with blocks zeroed blocks, reported to V8 as external
+ * memory. Returns NULL with an exception pending when that much memory is
+ * not available. */
+static XXH3BloomFilter_Wrapper_t *alloc_filter(napi_env env,
+                                               uint64_t blocks) {
+   XXH3BloomFilter_Wrapper_t *f = calloc(1, sizeof(*f));
+   int64_t unused;
+
+   if (f == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   f->env_ = env;
+   f->blocks_ = blocks;
+   if (blocks > SIZE_MAX / CACHE_LINE_SIZE ||
+       (f->bits_ = calloc_lines((size_t)blocks * CACHE_LINE_SIZE,
+                                &f->alloc_)) == NULL) {
+      free(f);
+      napi_throw_error(env, NULL, "Cannot allocate the filter");
+      return NULL;
+   }
+   napi_adjust_external_memory(env, (int64_t)(blocks * CACHE_LINE_SIZE),
+                               &unused);
+   return f;
+}
+
+static void destroy(napi_env _unused_env, void *obj, void *_unused_hint) {
+   XXH3BloomFilter_Wrapper_t *f = (XXH3BloomFilter_Wrapper_t *)obj;
+   int64_t unused;
+   (void)_unused_env;
+   (void)_unused_hint;
+   napi_delete_reference(f->env_, f->wrapper_);
+   napi_adjust_external_memory(
+       f->env_, -(int64_t)(f->blocks_ * CACHE_LINE_SIZE), &unused);
+   free(f->alloc_);
+   free(f);
+}
+
+/* new XXH3BloomFilter(expectedItems[, falsePositiveRate[, seed]]) sizes the
+ * filter for the rate at expectedItems keys. It starts from the textbook
+ * n ln(1/p) / ln(2)^2 bits, setting ln(2) bits / n bits per key, and grows
+ * in 5% steps until the blocked layout meets the rate. */
+static napi_value create_instance(napi_env env, napi_callback_info info) {
+   size_t argc = 3;
+   napi_value args[3];
+   napi_value jsthis;
+   napi_valuetype type = napi_undefined;
+   Class_data_t *class_data;
+   XXH3BloomFilter_Wrapper_t *obj;
+   XXH64_hash_t seed = 0;
+   double items = 0;
+   double rate = BLOOM_DEFAULT_RATE;
+   double bits;
+   double blocks;
+   double hashes;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, (void **)&class_data);
+   if (class_data->adopted_ != NULL) {
+      obj = (XXH3BloomFilter_Wrapper_t *)class_data->adopted_;
+      class_data->adopted_ = NULL;
+      napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+      return jsthis;
+   }
+
+   if (argc < 1 || napi_get_value_double(env, args[0], &items) != napi_ok ||
+       !(items >= 1 && items <= 9007199254740991.0)) {
+      napi_throw_range_error(env, NULL, "expectedItems must be >= 1");
+      return NULL;
+   }
+   if (argc > 1) {
+      napi_typeof(env, args[1], &type);
+   }
+   if (type != napi_undefined &&
+       (napi_get_value_double(env, args[1], &rate) != napi_ok ||
+        !(rate > 0 && rate < 1))) {
+      napi_throw_range_error(env, NULL,
+                             "falsePositiveRate must be in (0, 1)");
+      return NULL;
+   }
+   type = napi_undefined;
+   if (argc > 2) {
+      napi_typeof(env, args[2], &type);
+   }
+   if (type != napi_undefined &&
+       get_seed_value(env, args[2], KEY_SEED64, &seed) != ADDON_OK) {
+      return NULL;
+   }
+
+   bits = -items * log(rate) / (BLOOM_LN2 * BLOOM_LN2);
+   for (;;) {
+      blocks = ceil(bits / (BLOOM_BLOCK_WORDS * 64));
+      if (blocks > (double)BLOOM_MAX_BLOCKS) {
+         napi_throw_range_error(env, NULL, "The filter would be too large");
+         return NULL;
+      }
+      hashes = floor(blocks * BLOOM_BLOCK_WORDS * 64 / items * BLOOM_LN2 +
+                     0.5);
+      hashes = hashes < 1                  ? 1
+               : hashes > BLOOM_MAX_HASHES ? BLOOM_MAX_HASHES
+                                           : hashes;
+      if (blocked_rate(items, blocks, hashes) <= rate) {
+         break;
+      }
+      bits = blocks * BLOOM_BLOCK_WORDS * 64 * 1.05;
+   }
+   obj = alloc_filter(env, (uint64_t)blocks);
+   if (obj == NULL) {
+      return NULL;
+   }
+   obj->hashes_ = (uint32_t)hashes;
+   obj->seed_ = seed;
+   napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+   return jsthis;
+}
+
+/* add(key) returns whether key was surely not in the filter before. has(key)
+ * is false when key was never added, and true when it was or, at about the
+ * false positive rate, when it was not. */
+static napi_value for_one(napi_env env, napi_callback_info info,
+                          int adding) {
+   size_t argc = 1;
+   napi_value args[1];
+   napi_value jsthis;
+   napi_value result;
+   Input_t input;
+   XXH3BloomFilter_Wrapper_t *f;
+   XXH64_hash_t h;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc < 1) {
+      napi_throw_range_error(env, NULL, "One param is expected");
+      return NULL;
+   }
+   if (get_input(env, args[0], &input) != ADDON_OK) {
+      return NULL;
+   }
+   napi_unwrap(env, jsthis, (void **)&f);
+   h = XXH3_64bits_withSeed(input.data_, input.len_, f->seed_);
+   RELEASE_INPUT(input)
+   napi_get_boolean(env, adding ? bloom_add(f, h) : bloom_has(f, h),
+                    &result);
+   return result;
+}
+
+static napi_value add(napi_env env, napi_callback_info info) {
+   return for_one(env, info, 1);
+}
+
+static napi_value has(napi_env env, napi_callback_info info) {
+   return for_one(env, info, 0);
+}
+
+/* addMany(keys[, layout]) and hasMany(keys[, layout]) return a Uint8Array
+ * with the add() or has() result of every key, as 1 or 0. */
+static napi_value for_many(napi_env env, napi_callback_info info,
+                           int adding) {
+   size_t argc = 2;
+   napi_value args[2];
+   napi_value jsthis;
+   napi_value buffer;
+   napi_value result;
+   XXH3BloomFilter_Wrapper_t *f;
+   XXH64_hash_t *hashes;
+   unsigned char *out;
+   uint32_t count;
+   uint32_t i;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc < 1) {
+      napi_throw_range_error(env, NULL, "At least one param is expected");
+      return NULL;
+   }
+   napi_unwrap(env, jsthis, (void **)&f);
+   if (get_key_hashes(env, args[0], argc > 1 ? args[1] : NULL, f->seed_,
+                      &hashes, &count) != ADDON_OK) {
+      return NULL;
+   }
+   napi_create_arraybuffer(env, count, (void **)&out, &buffer);
+   for (i = 0; i < count; i++) {
+      if (i + MEMBERSHIP_PREFETCH < count) {
+         PREFETCH(block_of(f, hashes[i + MEMBERSHIP_PREFETCH]));
+      }
+      out[i] = (unsigned char)(adding ? bloom_add(f, hashes[i])
+                                      : bloom_has(f, hashes[i]));
+   }
+   free(hashes);
+   napi_create_typedarray(env, napi_uint8_array, count, buffer, 0, &result);
+   return result;
+}
+
+static napi_value add_many(napi_env env, napi_callback_info info) {
+   return for_many(env, info, 1);
+}
+
+static napi_value has_many(napi_env env, napi_callback_info info) {
+   return for_many(env, info, 0);
+}
+
+static napi_value export_state(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   napi_value result = NULL;
+   XXH3BloomFilter_Wrapper_t *f;
+   unsigned char *start;
+   unsigned char *p;
+   uint64_t words;
+   uint64_t i;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&f);
+   words = f->blocks_ * BLOOM_BLOCK_WORDS;
+   p = open_state(env, STATE_BLOOM, BLOOM_STATE_FIELDS + words * 8, &result);
+   if (p == NULL) {
+      return NULL;
+   }
+   start = p - STATE_HEADER_SIZE;
+   p = put_u64(p, f->seed_);
+   p = put_u32(p, f->hashes_);
+   p = put_u64(p, f->blocks_);
+   for (i = 0; i < words; i++) {
+      p = put_u64(p, f->bits_[i]);
+   }
+   seal_state(start, p);
+   return result;
+}
+
+/* XXH3BloomFilter.importState(state) */
+static napi_value import_state(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   Class_data_t *class_data;
+   XXH3BloomFilter_Wrapper_t *obj;
+   Input_t input;
+   const unsigned char *p;
+   size_t size;
+   XXH64_hash_t seed;
+   uint32_t hashes;
+   uint64_t blocks;
+   uint64_t words;
+   uint64_t i;
+
+   napi_get_cb_info(env, info, &argc, args, NULL, (void **)&class_data);
+   p = open_import(env, argc < 1 ? NULL : args[0], STATE_BLOOM, &input,
+                   &size);
+   if (p == NULL) {
+      return NULL;
+   }
+   if (size < BLOOM_STATE_FIELDS) {
+      state_corrupt(env, &input);
+      return NULL;
+   }
+   seed = get_u64(&p);
+   hashes = get_u32(&p);
+   blocks = get_u64(&p);
+   if (hashes < 1 || hashes > BLOOM_MAX_HASHES || blocks < 1 ||
+       blocks > BLOOM_MAX_BLOCKS ||
+       (size - BLOOM_STATE_FIELDS) / CACHE_LINE_SIZE != blocks ||
+       (size - BLOOM_STATE_FIELDS) % CACHE_LINE_SIZE != 0) {
+      state_corrupt(env, &input);
+      return NULL;
+   }
+   obj = alloc_filter(env, blocks);
+   if (obj == NULL) {
+      RELEASE_INPUT(input)
+      return NULL;
+   }
+   obj->seed_ = seed;
+   obj->hashes_ = hashes;
+   words = blocks * BLOOM_BLOCK_WORDS;
+   for (i = 0; i < words; i++) {
+      obj->bits_[i] = get_u64(&p);
+   }
+   RELEASE_INPUT(input)
+   return new_adopted_instance(env, class_data, obj, destroy);
+}
+
+napi_value init_XXH3BloomFilter(napi_env env, napi_value exports) {
+   Class_data_t *class_data = create_class_data(env);
+   napi_property_descriptor properties[] = {
+       {"add", NULL, add, NULL, NULL, NULL, napi_default, NULL},
+       {"has", NULL, has, NULL, NULL, NULL, napi_default, NULL},
+       {"addMany", NULL, add_many, NULL, NULL, NULL, napi_default, NULL},
+       {"hasMany", NULL, has_many, NULL, NULL, NULL, napi_default, NULL},
+       {"exportState", NULL, export_state, NULL, NULL, NULL, napi_default,
+        NULL},
+       {"importState", NULL, import_state, NULL, NULL, NULL, napi_static,
+        class_data}};
+   DEFINE_CLASS(XXH3BloomFilter, class_data)
+}
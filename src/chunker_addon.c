@@ -0,0 +1,354 @@
+#include "xxhash_addon.h"
+
+#include <uv.h>
+
+/* Content-defined chunking in the FastCDC style (Xia et al., 2016): a Gear
+ * rolling hash, fp = (fp << 1) + gear[byte], cuts a chunk where the top
+ * bits of fp are all zero. The first minSize bytes of a chunk are skipped
+ * unscanned; up to avgSize a stricter mask (2 bits more than log2(avgSize))
+ * is used and past it a looser one (2 bits fewer), which narrows the chunk
+ * size distribution around avgSize; maxSize forces a cut. gear[b] is
+ * XXH64() of the single byte b with seed 0, so boundaries can be reproduced
+ * elsewhere. Each chunk is digested right after its boundary is found,
+ * while its bytes are still in cache. */
+#define CHUNKER_DEFAULT_MIN (2 << 10)
+#define CHUNKER_DEFAULT_AVG (8 << 10)
+#define CHUNKER_DEFAULT_MAX (64 << 10)
+#define CHUNKER_MIN_SIZE 64
+#define CHUNKER_MIN_AVG 256
+#define CHUNKER_MAX_SIZE 1073741824
+#define CHUNKER_NORMALIZATION 2
+
+static uint64_t gear[256];
+static uv_once_t gear_once = UV_ONCE_INIT;
+
+static void gear_init(void) {
+   unsigned char b;
+   int i;
+
+   for (i = 0; i < 256; i++) {
+      b = (unsigned char)i;
+      gear[i] = XXH64(&b, 1, 0);
+   }
+}
+
+/* The top bits ones of a 64-bit word. */
+static uint64_t top_mask(unsigned int bits) {
+   return bits == 0 ? 0 : ~(uint64_t)0 << (64 - bits);
+}
+
+/* Scans data from pos_ bytes into the current chunk. Returns how many bytes
+ * belong to it; *cut says whether the chunk ends there or continues past
+ * data. */
+static size_t find_cut(Chunker_Wrapper_t *c, const unsigned char *data,
+                       size_t len, int *cut) {
+   const size_t pos = c->pos_;
+   uint64_t fp = c->fp_;
+   size_t i = 0;
+   size_t end;
+
+   *cut = 0;
+   if (pos < c->minSize_) {
+      i = c->minSize_ - pos < len ? c->minSize_ - pos : len;
+   }
+   if (pos + i < c->avgSize_) {
+      end = c->avgSize_ - pos < len ? c->avgSize_ - pos : len;
+      for (; i < end; i++) {
+         fp = (fp << 1) + gear[data[i]];
+         if ((fp & c->maskS_) == 0) {
+            *cut = 1;
+            i++;
+            goto done;
+         }
+      }
+   }
+   end = c->maxSize_ - pos < len ? c->maxSize_ - pos : len;
+   for (; i < end; i++) {
+      fp = (fp << 1) + gear[data[i]];
+      if ((fp & c->maskL_) == 0) {
+         *cut = 1;
+         i++;
+         goto done;
+      }
+   }
+   *cut = pos + i == c->maxSize_;
+
+done:
+   c->fp_ = fp;
+   c->pos_ = pos + i;
+   return i;
+}
+
+static void push_record(Chunker_Wrapper_t *c, const void *data, size_t len) {
+   size_t digest_size = c->wide_ ? sizeof(XXH128_canonical_t)
+                                 : sizeof(XXH64_canonical_t);
+   size_t capacity;
+   unsigned char *digest;
+
+   if (c->count_ == c->capacity_) {
+      capacity = c->capacity_ == 0 ? 64 : c->capacity_ * 2;
+      c->offsets_ = realloc(c->offsets_, capacity * sizeof(double));
+      c->lengths_ = realloc(c->lengths_, capacity * sizeof(uint32_t));
+      c->digests_ = realloc(c->digests_, capacity * digest_size);
+      if (c->offsets_ == NULL || c->lengths_ == NULL ||
+          c->digests_ == NULL) {
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+         return;
+      }
+      c->capacity_ = capacity;
+   }
+
+   digest = c->digests_ + c->count_ * digest_size;
+   if (c->wide_) {
+      XXH128_canonicalFromHash(
+          (XXH128_canonical_t *)digest,
+          data != NULL ? XXH3_128bits_withSeed(data, len, c->seed_)
+                       : XXH3_128bits_digest(c->state_));
+   } else {
+      XXH64_canonicalFromHash(
+          (XXH64_canonical_t *)digest,
+          data != NULL ? XXH3_64bits_withSeed(data, len, c->seed_)
+                       : XXH3_64bits_digest(c->state_));
+   }
+   c->offsets_[c->count_] = (double)c->offset_;
+   c->lengths_[c->count_] = (uint32_t)c->pos_;
+   c->count_++;
+
+   c->offset_ += c->pos_;
+   c->pos_ = 0;
+   c->fp_ = 0;
+   c->streaming_ = 0;
+}
+
+/* A chunk that lies within one update() is digested in one shot; one that
+ * spans calls goes through state_, fed as its bytes arrive. The 64- and
+ * 128-bit XXH3 streaming updates are the same function. */
+static void chunk_data(Chunker_Wrapper_t *c, const unsigned char *data,
+                       size_t len) {
+   size_t n;
+   int cut;
+
+   while (len > 0) {
+      n = find_cut(c, data, len, &cut);
+      if (!c->streaming_ && cut) {
+         push_record(c, data, c->pos_);
+      } else {
+         if (!c->streaming_) {
+            XXH3_64bits_reset_withSeed(c->state_, c->seed_);
+            c->streaming_ = 1;
+         }
+         XXH3_64bits_update(c->state_, data, n);
+         if (cut) {
+            push_record(c, NULL, 0);
+         }
+      }
+      data += n;
+      len -= n;
+   }
+}
+
+/* Hands the records gathered so far to JS as { offsets, lengths, digests }:
+ * a Float64Array of stream offsets, a Uint32Array of lengths and a Buffer of
+ * canonical digests, back to back. */
+static napi_value take_records(napi_env env, Chunker_Wrapper_t *c) {
+   size_t digest_size = c->wide_ ? sizeof(XXH128_canonical_t)
+                                 : sizeof(XXH64_canonical_t);
+   napi_value result;
+   napi_value buffer;
+   napi_value array;
+   void *data;
+
+   napi_create_object(env, &result);
+   napi_create_arraybuffer(env, c->count_ * sizeof(double), &data, &buffer);
+   if (c->count_ > 0) {
+      memcpy(data, c->offsets_, c->count_ * sizeof(double));
+   }
+   napi_create_typedarray(env, napi_float64_array, c->count_, buffer, 0,
+                          &array);
+   napi_set_named_property(env, result, "offsets", array);
+   napi_create_arraybuffer(env, c->count_ * sizeof(uint32_t), &data,
+                           &buffer);
+   if (c->count_ > 0) {
+      memcpy(data, c->lengths_, c->count_ * sizeof(uint32_t));
+   }
+   napi_create_typedarray(env, napi_uint32_array, c->count_, buffer, 0,
+                          &array);
+   napi_set_named_property(env, result, "lengths", array);
+   napi_create_buffer_copy(env, c->count_ * digest_size,
+                           c->count_ > 0 ? (void *)c->digests_ : (void *)"",
+                           NULL, &array);
+   napi_set_named_property(env, result, "digests", array);
+   c->count_ = 0;
+   return result;
+}
+
+static ADDON_errorcode get_size_option(napi_env env, napi_value options,
+                                       const char *name, size_t *size) {
+   bool has_field = false;
+   napi_value field;
+   int64_t number;
+
+   napi_has_named_property(env, options, name, &has_field);
+   if (!has_field) {
+      return ADDON_OK;
+   }
+   napi_get_named_property(env, options, name, &field);
+   if (napi_get_value_int64(env, field, &number) != napi_ok ||
+       number < CHUNKER_MIN_SIZE || number > CHUNKER_MAX_SIZE) {
+      napi_throw_range_error(env, NULL,
+                             "Chunk sizes must be in [" QUOTE(
+                                 CHUNKER_MIN_SIZE) ", 2^30]");
+      return ADDON_ERROR;
+   }
+   *size = (size_t)number;
+   return ADDON_OK;
+}
+
+/* Parses { minSize, avgSize, maxSize, algorithm, seed } into c. */
+static ADDON_errorcode get_chunker_options(napi_env env, napi_value options,
+                                           Chunker_Wrapper_t *c) {
+   napi_valuetype type = napi_undefined;
+   bool has_field = false;
+   napi_value field;
+   char algorithm[8];
+   size_t len;
+   unsigned int bits;
+
+   c->minSize_ = CHUNKER_DEFAULT_MIN;
+   c->avgSize_ = CHUNKER_DEFAULT_AVG;
+   c->maxSize_ = CHUNKER_DEFAULT_MAX;
+   c->wide_ = 1;
+   c->seed_ = 0;
+   if (options != NULL) {
+      napi_typeof(env, options, &type);
+   }
+   if (type != napi_undefined) {
+      if (type != napi_object) {
+         napi_throw_type_error(env, NULL, "Options must be an object");
+         return ADDON_ERROR;
+      }
+      if (get_size_option(env, options, "minSize", &c->minSize_) !=
+              ADDON_OK ||
+          get_size_option(env, options, "avgSize", &c->avgSize_) !=
+              ADDON_OK ||
+          get_size_option(env, options, "maxSize", &c->maxSize_) !=
+              ADDON_OK) {
+         return ADDON_ERROR;
+      }
+      napi_has_named_property(env, options, "algorithm", &has_field);
+      if (has_field) {
+         napi_get_named_property(env, options, "algorithm", &field);
+         if (napi_get_value_string_utf8(env, field, algorithm,
+                                        sizeof(algorithm), &len) != napi_ok ||
+             (strcmp(algorithm, "xxh3") != 0 &&
+              strcmp(algorithm, "xxh128") != 0)) {
+            napi_throw_type_error(env, NULL,
+                                  "algorithm must be 'xxh3' or 'xxh128'");
+            return ADDON_ERROR;
+         }
+         c->wide_ = strcmp(algorithm, "xxh128") == 0;
+      }
+      napi_has_named_property(env, options, "seed", &has_field);
+      if (has_field) {
+         napi_get_named_property(env, options, "seed", &field);
+         if (get_seed_value(env, field, KEY_SEED64, &c->seed_) != ADDON_OK) {
+            return ADDON_ERROR;
+         }
+      }
+   }
+   if (c->avgSize_ < CHUNKER_MIN_AVG || c->minSize_ > c->avgSize_ ||
+       c->avgSize_ > c->maxSize_) {
+      napi_throw_range_error(env, NULL,
+                             "Expected minSize <= avgSize <= maxSize and "
+                             "avgSize >= " QUOTE(CHUNKER_MIN_AVG));
+      return ADDON_ERROR;
+   }
+
+   for (bits = 0; ((size_t)2 << bits) <= c->avgSize_; bits++) {
+   }
+   c->maskS_ = top_mask(bits + CHUNKER_NORMALIZATION);
+   c->maskL_ = top_mask(bits - CHUNKER_NORMALIZATION);
+   return ADDON_OK;
+}
+
+static void destroy(napi_env _unused_env, void *obj, void *_unused_hint) {
+   Chunker_Wrapper_t *c = (Chunker_Wrapper_t *)obj;
+   (void)_unused_env;
+   (void)_unused_hint;
+   napi_delete_reference(c->env_, c->wrapper_);
+   XXH3_freeState(c->state_);
+   free(c->offsets_);
+   free(c->lengths_);
+   free(c->digests_);
+   free(c);
+}
+
+/* new Chunker([options]) */
+static napi_value create_instance(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   napi_value jsthis;
+   Chunker_Wrapper_t *obj;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   obj = calloc(1, sizeof(Chunker_Wrapper_t));
+   if (obj == NULL || (obj->state_ = XXH3_createState()) == NULL) {
+      free(obj);
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   if (get_chunker_options(env, argc > 0 ? args[0] : NULL, obj) !=
+       ADDON_OK) {
+      XXH3_freeState(obj->state_);
+      free(obj);
+      return NULL;
+   }
+   uv_once(&gear_once, gear_init);
+   obj->env_ = env;
+   napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+   return jsthis;
+}
+
+/* update(data) returns the chunks that data completes. */
+static napi_value update(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   napi_value jsthis;
+   Input_t input;
+   Chunker_Wrapper_t *c;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc < 1) {
+      napi_throw_range_error(env, NULL, "One param is expected");
+      return NULL;
+   }
+   if (get_input(env, args[0], &input) != ADDON_OK) {
+      return NULL;
+   }
+   napi_unwrap(env, jsthis, (void **)&c);
+   chunk_data(c, (const unsigned char *)input.data_, input.len_);
+   RELEASE_INPUT(input)
+   return take_records(env, c);
+}
+
+/* finish() returns the last, possibly short, chunk and starts a new stream
+ * at offset 0. */
+static napi_value finish(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   Chunker_Wrapper_t *c;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&c);
+   if (c->pos_ > 0) {
+      push_record(c, NULL, 0);
+   }
+   c->offset_ = 0;
+   return take_records(env, c);
+}
+
+napi_value init_Chunker(napi_env env, napi_value exports) {
+   napi_property_descriptor properties[] = {
+       {"update", NULL, update, NULL, NULL, NULL, napi_default, NULL},
+       {"finish", NULL, finish, NULL, NULL, NULL, napi_default, NULL}};
+   DEFINE_CLASS(Chunker, (Class_data_t *)NULL)
+}
@@ -0,0 +1,268 @@
+#include "xxhash_addon.h"
+
+/* A row's key is the concatenation of its value in every column, in column
+ * order. A fixed-width value contributes its element bytes, little-endian;
+ * a variable-width value a uint32 little-endian length followed by its
+ * bytes, so that ("ab", "c") and ("a", "bc") make different keys. Keys are
+ * built a block of rows at a time: fixed-width columns are transposed into
+ * a row-major scratch block with copies specialised on the element width,
+ * and a lone fixed-width column on a little-endian host is hashed in place
+ * with no copy at all. */
+
+static int host_is_little_endian(void) {
+   const uint16_t one = 1;
+   return *(const unsigned char *)&one;
+}
+
+/* Copies rows elements of width bytes from src into dst, stride bytes
+ * apart. Constant-size memcpy()s compile to plain loads and stores. */
+static void gather_fixed(unsigned char *dst, size_t stride,
+                         const unsigned char *src, size_t width, size_t rows,
+                         int swap) {
+   size_t r;
+   size_t b;
+
+   if (swap && width > 1) {
+      for (r = 0; r < rows; r++, dst += stride, src += width) {
+         for (b = 0; b < width; b++) {
+            dst[b] = src[width - 1 - b];
+         }
+      }
+      return;
+   }
+   switch (width) {
+   case 1:
+      for (r = 0; r < rows; r++) {
+         dst[r * stride] = src[r];
+      }
+      break;
+   case 2:
+      for (r = 0; r < rows; r++) {
+         memcpy(dst + r * stride, src + r * 2, 2);
+      }
+      break;
+   case 4:
+      for (r = 0; r < rows; r++) {
+         memcpy(dst + r * stride, src + r * 4, 4);
+      }
+      break;
+   default:
+      for (r = 0; r < rows; r++) {
+         memcpy(dst + r * stride, src + r * 8, 8);
+      }
+      break;
+   }
+}
+
+static unsigned char *put_length(unsigned char *p, uint32_t len) {
+   p[0] = (unsigned char)len;
+   p[1] = (unsigned char)(len >> 8);
+   p[2] = (unsigned char)(len >> 16);
+   p[3] = (unsigned char)(len >> 24);
+   return p + 4;
+}
+
+static ADDON_errorcode reserve_scratch(Column_set_t *set, size_t size) {
+   unsigned char *scratch;
+
+   if (size <= set->scratch_size_) {
+      return ADDON_OK;
+   }
+   scratch = realloc(set->scratch_, size);
+   if (scratch == NULL) {
+      return ADDON_ERROR;
+   }
+   set->scratch_ = scratch;
+   set->scratch_size_ = size;
+   return ADDON_OK;
+}
+
+/* Builds the keys of rows [first, first + rows), rows <= COLUMN_BLOCK_ROWS,
+ * back to back; ends[i] is where the key of row first + i ends. Returns NULL
+ * when out of memory. */
+const unsigned char *column_keys(Column_set_t *set, uint32_t first,
+                                 uint32_t rows, size_t *ends) {
+   const Column_t *column;
+   unsigned char *p;
+   size_t size;
+   size_t offset;
+   uint32_t c;
+   uint32_t r;
+   uint32_t len;
+
+   if (set->in_place_) {
+      for (r = 0; r < rows; r++) {
+         ends[r] = (r + 1) * set->row_width_;
+      }
+      return set->columns_[0].data_ + (size_t)first * set->row_width_;
+   }
+
+   if (set->variable_ == 0) {
+      if (reserve_scratch(set, rows * set->row_width_) != ADDON_OK) {
+         return NULL;
+      }
+      offset = 0;
+      for (c = 0; c < set->count_; c++) {
+         column = &set->columns_[c];
+         gather_fixed(set->scratch_ + offset, set->row_width_,
+                      column->data_ + (size_t)first * column->width_,
+                      column->width_, rows, set->swap_);
+         offset += column->width_;
+      }
+      for (r = 0; r < rows; r++) {
+         ends[r] = (r + 1) * set->row_width_;
+      }
+      return set->scratch_;
+   }
+
+   size = (size_t)rows * (set->row_width_ + 4 * set->variable_);
+   for (c = 0; c < set->count_; c++) {
+      column = &set->columns_[c];
+      if (column->offsets_ != NULL) {
+         size += column->offsets_[first + rows] - column->offsets_[first];
+      }
+   }
+   if (reserve_scratch(set, size) != ADDON_OK) {
+      return NULL;
+   }
+   p = set->scratch_;
+   for (r = first; r < first + rows; r++) {
+      for (c = 0; c < set->count_; c++) {
+         column = &set->columns_[c];
+         if (column->offsets_ == NULL) {
+            gather_fixed(p, 0, column->data_ + (size_t)r * column->width_,
+                         column->width_, 1, set->swap_);
+            p += column->width_;
+         } else {
+            len = column->offsets_[r + 1] - column->offsets_[r];
+            p = put_length(p, len);
+            memcpy(p, column->data_ + column->offsets_[r], len);
+            p += len;
+         }
+      }
+      ends[r - first] = (size_t)(p - set->scratch_);
+   }
+   return set->scratch_;
+}
+
+static ADDON_errorcode get_column(napi_env env, napi_value value,
+                                  uint32_t row_count, Column_t *column) {
+   bool is_typedarray = false;
+   bool has_data = false;
+   napi_valuetype type;
+   napi_typedarray_type element_type;
+   napi_value field;
+   size_t length;
+   void *data;
+   const uint32_t *offsets;
+   uint32_t count;
+
+   column->offsets_ = NULL;
+   napi_is_typedarray(env, value, &is_typedarray);
+   if (is_typedarray) {
+      napi_get_typedarray_info(env, value, &element_type, &length, &data,
+                               NULL, NULL);
+      switch (element_type) {
+      case napi_int8_array:
+      case napi_uint8_array:
+      case napi_uint8_clamped_array:
+         column->width_ = 1;
+         break;
+      case napi_int16_array:
+      case napi_uint16_array:
+         column->width_ = 2;
+         break;
+      case napi_int32_array:
+      case napi_uint32_array:
+      case napi_float32_array:
+         column->width_ = 4;
+         break;
+      default:
+         column->width_ = 8;
+         break;
+      }
+      if (length < row_count) {
+         napi_throw_range_error(env, NULL, "Column is shorter than rowCount");
+         return ADDON_ERROR;
+      }
+      column->data_ = (const unsigned char *)data;
+      return ADDON_OK;
+   }
+
+   napi_typeof(env, value, &type);
+   if (type == napi_object) {
+      napi_has_named_property(env, value, "data", &has_data);
+   }
+   if (!has_data) {
+      napi_throw_type_error(env, NULL,
+                            "Columns must be TypedArrays or "
+                            "{ data, offsets } objects");
+      return ADDON_ERROR;
+   }
+   napi_get_named_property(env, value, "data", &field);
+   if (get_byte_range(env, field, &data, &length) != ADDON_OK) {
+      napi_throw_type_error(env, NULL, "Column data must be a buffer");
+      return ADDON_ERROR;
+   }
+   napi_get_named_property(env, value, "offsets", &field);
+   if (get_batch_offsets(env, field, length, &offsets, &count) != ADDON_OK) {
+      return ADDON_ERROR;
+   }
+   if (count < row_count) {
+      napi_throw_range_error(env, NULL, "Column is shorter than rowCount");
+      return ADDON_ERROR;
+   }
+   column->data_ = (const unsigned char *)data;
+   column->offsets_ = offsets;
+   column->width_ = 0;
+   return ADDON_OK;
+}
+
+/* Parses the columns and rowCount arguments of hashColumns(). On success
+ * the caller owns set and releases it with RELEASE_COLUMNS. */
+ADDON_errorcode get_columns(napi_env env, napi_value columns,
+                            napi_value rows, Column_set_t *set) {
+   bool is_array = false;
+   napi_value elem;
+   int64_t row_count;
+   uint32_t c;
+
+   memset(set, 0, sizeof(*set));
+   napi_is_array(env, columns, &is_array);
+   if (!is_array) {
+      napi_throw_type_error(env, NULL, "Columns must be an array");
+      return ADDON_ERROR;
+   }
+   if (napi_get_value_int64(env, rows, &row_count) != napi_ok ||
+       row_count < 0 || row_count > UINT32_MAX) {
+      napi_throw_range_error(env, NULL, "rowCount must be in [0, 2^32)");
+      return ADDON_ERROR;
+   }
+   napi_get_array_length(env, columns, &set->count_);
+   if (set->count_ == 0) {
+      napi_throw_range_error(env, NULL, "At least one column is expected");
+      return ADDON_ERROR;
+   }
+   set->columns_ = malloc(set->count_ * sizeof(Column_t));
+   if (set->columns_ == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return ADDON_ERROR;
+   }
+   set->rows_ = (uint32_t)row_count;
+   set->swap_ = !host_is_little_endian();
+   for (c = 0; c < set->count_; c++) {
+      napi_get_element(env, columns, c, &elem);
+      if (get_column(env, elem, set->rows_, &set->columns_[c]) != ADDON_OK) {
+         RELEASE_COLUMNS(*set)
+         return ADDON_ERROR;
+      }
+      if (set->columns_[c].offsets_ == NULL) {
+         set->row_width_ += set->columns_[c].width_;
+      } else {
+         set->variable_++;
+      }
+   }
+   set->in_place_ = set->count_ == 1 && set->variable_ == 0 &&
+                    (!set->swap_ || set->row_width_ == 1);
+   return ADDON_OK;
+}
@@ -0,0 +1,184 @@
+#include "xxhash_addon.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <uv.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+/* Files are read, never mapped: a mapped file that another process
+ * truncates mid-hash (log rotation, a file still being written) raises
+ * SIGBUS, where a read just comes back short. Chunks are sized to stay in
+ * L2, so each one is hashed while the copy is still in cache. */
+#define FILE_READ_CHUNK (256 << 10)
+
+static int read_range(uv_file fd, uint64_t offset, uint64_t length,
+                      File_consumer consume, void *ctx) {
+   size_t chunk_size =
+       length < FILE_READ_CHUNK ? (size_t)length : FILE_READ_CHUNK;
+   char *chunk;
+   uv_fs_t req;
+   uv_buf_t buf;
+   int nread;
+
+   if (length == 0) {
+      return 0;
+   }
+   chunk = malloc(chunk_size);
+   if (chunk == NULL) {
+      return UV_ENOMEM;
+   }
+   while (length > 0) {
+      buf = uv_buf_init(chunk, (unsigned int)(length < chunk_size
+                                                  ? (size_t)length
+                                                  : chunk_size));
+      nread = uv_fs_read(NULL, &req, fd, &buf, 1, (int64_t)offset, NULL);
+      uv_fs_req_cleanup(&req);
+      if (nread < 0) {
+         free(chunk);
+         return nread;
+      }
+      if (nread == 0) {
+         break; /* file shrank underneath us */
+      }
+      consume(ctx, chunk, (size_t)nread);
+      offset += (uint64_t)nread;
+      length -= (uint64_t)nread;
+   }
+   free(chunk);
+   return 0;
+}
+
+int read_file_range(const char *path, uint64_t offset, uint64_t length,
+                    File_consumer consume, void *ctx) {
+   uv_fs_t req;
+   uv_file fd;
+   uint64_t size;
+   int err;
+
+   fd = uv_fs_open(NULL, &req, path, UV_FS_O_RDONLY, 0, NULL);
+   uv_fs_req_cleanup(&req);
+   if (fd < 0) {
+      return fd;
+   }
+   err = uv_fs_fstat(NULL, &req, fd, NULL);
+   size = req.statbuf.st_size;
+   uv_fs_req_cleanup(&req);
+
+   if (err == 0) {
+      /* Same clamping as fs.createReadStream({ start, end }). */
+      if (offset > size) {
+         offset = size;
+      }
+      if (length > size - offset) {
+         length = size - offset;
+      }
+#ifdef POSIX_FADV_SEQUENTIAL
+      posix_fadvise(fd, (off_t)offset, (off_t)length,
+                    POSIX_FADV_SEQUENTIAL);
+#endif
+      err = read_range(fd, offset, length, consume, ctx);
+   }
+
+   uv_fs_close(NULL, &req, fd, NULL);
+   uv_fs_req_cleanup(&req);
+   return err;
+}
+
+/* Reads an offset or length of hashFile(): a safe integer >= 0, or, where
+ * to_eof allows it, +Infinity for "to the end of the file" as in
+ * fs.createReadStream(). undefined leaves *result as it is; anything else
+ * throws a RangeError with the given message. */
+static ADDON_errorcode get_file_position(napi_env env, napi_value value,
+                                         bool to_eof, const char *message,
+                                         uint64_t *result) {
+   napi_valuetype type = napi_undefined;
+   double number;
+
+   napi_typeof(env, value, &type);
+   if (type == napi_undefined) {
+      return ADDON_OK;
+   }
+   if (type == napi_number) {
+      napi_get_value_double(env, value, &number);
+   } else {
+      number = NAN;
+   }
+   if (to_eof && number == INFINITY) {
+      *result = UINT64_MAX;
+      return ADDON_OK;
+   }
+   if (!(number >= 0 && number <= 9007199254740991.0 &&
+         number == (double)(uint64_t)number)) {
+      napi_throw_range_error(env, NULL, message);
+      return ADDON_ERROR;
+   }
+   *result = (uint64_t)number;
+   return ADDON_OK;
+}
+
+/* Parses (path[, offset[, length]]) for hashFile()/hashFileAsync(). The
+ * returned path is malloc'ed and owned by the caller. */
+ADDON_errorcode get_file_args(napi_env env, napi_callback_info info,
+                              char **path, uint64_t *offset,
+                              uint64_t *length) {
+   size_t argc = 3;
+   napi_value args[3];
+   size_t path_len;
+
+   napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+   if (argc < 1 ||
+       napi_get_value_string_utf8(env, args[0], NULL, 0, &path_len) !=
+           napi_ok) {
+      napi_throw_type_error(env, NULL, "Path must be a string");
+      return ADDON_ERROR;
+   }
+
+   *offset = 0;
+   *length = UINT64_MAX;
+   if (argc > 1 &&
+       get_file_position(env, args[1], false,
+                         "Offset must be an integer >= 0",
+                         offset) != ADDON_OK) {
+      return ADDON_ERROR;
+   }
+   if (argc > 2 &&
+       get_file_position(env, args[2], true,
+                         "Length must be an integer >= 0 or Infinity",
+                         length) != ADDON_OK) {
+      return ADDON_ERROR;
+   }
+
+   *path = malloc(path_len + 1);
+   if (*path == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return ADDON_ERROR;
+   }
+   napi_get_value_string_utf8(env, args[0], *path, path_len + 1, &path_len);
+   return ADDON_OK;
+}
+
+/* Builds an Error shaped like Node's fs errors, e.g.
+ * "ENOENT: no such file or directory, 'x'" with code "ENOENT". */
+napi_value create_file_error(napi_env env, int err, const char *path) {
+   const char *format = "%s: %s, '%s'";
+   size_t size = strlen(format) + strlen(uv_err_name(err)) +
+                 strlen(uv_strerror(err)) + strlen(path);
+   char *text = malloc(size);
+   napi_value code;
+   napi_value message;
+   napi_value error;
+
+   if (text == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   snprintf(text, size, format, uv_err_name(err), uv_strerror(err), path);
+   napi_create_string_utf8(env, uv_err_name(err), NAPI_AUTO_LENGTH, &code);
+   napi_create_string_utf8(env, text, NAPI_AUTO_LENGTH, &message);
+   napi_create_error(env, code, message, &error);
+   free(text);
+   return error;
+}
@@ -0,0 +1,397 @@
+#include "xxhash_addon.h"
+
+/* A set that keeps the 64-bit XXH3_64bits_withSeed() of each key, not the
+ * key: 8 bytes an entry however long the keys, at the price of treating two
+ * keys with the same hash as one, which among n keys happens with
+ * probability about n^2 / 2^65. Hashes live in buckets of one cache line,
+ * 8 slots; the high 32 bits of a hash pick its home bucket and a full
+ * bucket spills into the next one. A hash of 0 is stored as 1, 0 marking a
+ * free slot. The table doubles before it is 3/4 full, so a lookup seldom
+ * reads more than the home line. */
+#define HASHSET_BUCKET_SLOTS (CACHE_LINE_SIZE / 8)
+#define HASHSET_BUCKET_LOAD (HASHSET_BUCKET_SLOTS * 3 / 4)
+#define HASHSET_MAX_BUCKETS ((uint64_t)1 << 32)
+
+/* Exported payload: seed u64 | size u64 | the stored hashes as u64, in no
+ * particular order. */
+#define HASHSET_STATE_FIELDS (8 + 8)
+
+static uint64_t fingerprint(XXH64_hash_t h) {
+   return h != 0 ? h : 1;
+}
+
+static uint64_t *bucket_of(const XXH3HashSet_Wrapper_t *s, uint64_t fp) {
+   return s->slots_ + ((fp >> 32) * s->buckets_ >> 32) * HASHSET_BUCKET_SLOTS;
+}
+
+/* Slots fill front to back and are never freed, so a bucket is a run of
+ * hashes then a run of free slots. scan() compares all 8 slots without
+ * branching, which random keys would mispredict: it returns whether fp is
+ * in the bucket and sets *used to the number of hashes in it. */
+static int scan(const uint64_t *bucket, uint64_t fp, int *used) {
+   int found = 0;
+   int i;
+
+   *used = 0;
+   for (i = 0; i < HASHSET_BUCKET_SLOTS; i++) {
+      found |= bucket[i] == fp;
+      *used += bucket[i] != 0;
+   }
+   return found;
+}
+
+/* Stores fp unless it is there already; returns whether it was stored. The
+ * table must have a free slot. */
+static int insert(XXH3HashSet_Wrapper_t *s, uint64_t fp) {
+   uint64_t *bucket = bucket_of(s, fp);
+   uint64_t *end = s->slots_ + s->buckets_ * HASHSET_BUCKET_SLOTS;
+   int used;
+
+   for (;;) {
+      if (scan(bucket, fp, &used)) {
+         return 0;
+      }
+      if (used < HASHSET_BUCKET_SLOTS) {
+         bucket[used] = fp;
+         s->size_++;
+         return 1;
+      }
+      bucket += HASHSET_BUCKET_SLOTS;
+      if (bucket == end) {
+         bucket = s->slots_;
+      }
+   }
+}
+
+static int contains(const XXH3HashSet_Wrapper_t *s, uint64_t fp) {
+   const uint64_t *bucket = bucket_of(s, fp);
+   const uint64_t *end = s->slots_ + s->buckets_ * HASHSET_BUCKET_SLOTS;
+   int used;
+
+   for (;;) {
+      if (scan(bucket, fp, &used)) {
+         return 1;
+      }
+      if (used < HASHSET_BUCKET_SLOTS) {
+         return 0;
+      }
+      bucket += HASHSET_BUCKET_SLOTS;
+      if (bucket == end) {
+         bucket = s->slots_;
+      }
+   }
+}
+
+/* Moves the set into a table of buckets buckets, reported to V8 as external
+ * memory. Returns ADDON_ERROR with an exception pending, and the set
+ * untouched, when that much memory is not available. */
+static ADDON_errorcode resize(napi_env env, XXH3HashSet_Wrapper_t *s,
+                              uint64_t buckets) {
+   XXH3HashSet_Wrapper_t old = *s;
+   uint64_t i;
+   int64_t unused;
+
+   if (buckets > HASHSET_MAX_BUCKETS ||
+       buckets > SIZE_MAX / CACHE_LINE_SIZE ||
+       (s->slots_ = calloc_lines((size_t)buckets * CACHE_LINE_SIZE,
+                                 &s->alloc_)) == NULL) {
+      *s = old;
+      napi_throw_error(env, NULL, "Cannot allocate the set");
+      return ADDON_ERROR;
+   }
+   s->buckets_ = buckets;
+   s->size_ = 0;
+   for (i = 0; i < old.buckets_ * HASHSET_BUCKET_SLOTS; i++) {
+      if (old.slots_[i] != 0) {
+         insert(s, old.slots_[i]);
+      }
+   }
+   free(old.alloc_);
+   napi_adjust_external_memory(
+       env, (int64_t)((buckets - old.buckets_) * CACHE_LINE_SIZE), &unused);
+   return ADDON_OK;
+}
+
+/* Makes room for one more hash. */
+static ADDON_errorcode reserve_one(napi_env env, XXH3HashSet_Wrapper_t *s) {
+   if (s->size_ < s->buckets_ * HASHSET_BUCKET_LOAD) {
+      return ADDON_OK;
+   }
+   return resize(env, s, s->buckets_ * 2);
+}
+
+static XXH3HashSet_Wrapper_t *alloc_set(napi_env env, double items) {
+   XXH3HashSet_Wrapper_t *s = calloc(1, sizeof(*s));
+   double buckets = items / HASHSET_BUCKET_LOAD + 1;
+
+   if (s == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   s->env_ = env;
+   if (buckets > (double)HASHSET_MAX_BUCKETS) {
+      free(s);
+      napi_throw_range_error(env, NULL, "The set would be too large");
+      return NULL;
+   }
+   if (resize(env, s, (uint64_t)buckets) != ADDON_OK) {
+      free(s);
+      return NULL;
+   }
+   return s;
+}
+
+static void destroy(napi_env _unused_env, void *obj, void *_unused_hint) {
+   XXH3HashSet_Wrapper_t *s = (XXH3HashSet_Wrapper_t *)obj;
+   int64_t unused;
+   (void)_unused_env;
+   (void)_unused_hint;
+   napi_delete_reference(s->env_, s->wrapper_);
+   napi_adjust_external_memory(
+       s->env_, -(int64_t)(s->buckets_ * CACHE_LINE_SIZE), &unused);
+   free(s->alloc_);
+   free(s);
+}
+
+/* new XXH3HashSet([expectedItems[, seed]]) sizes the table so that
+ * expectedItems keys fit without growing. */
+static napi_value create_instance(napi_env env, napi_callback_info info) {
+   size_t argc = 2;
+   napi_value args[2];
+   napi_value jsthis;
+   napi_valuetype type = napi_undefined;
+   Class_data_t *class_data;
+   XXH3HashSet_Wrapper_t *obj;
+   XXH64_hash_t seed = 0;
+   double items = 0;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, (void **)&class_data);
+   if (class_data->adopted_ != NULL) {
+      obj = (XXH3HashSet_Wrapper_t *)class_data->adopted_;
+      class_data->adopted_ = NULL;
+      napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+      return jsthis;
+   }
+
+   if (argc > 0) {
+      napi_typeof(env, args[0], &type);
+   }
+   if (type != napi_undefined &&
+       (napi_get_value_double(env, args[0], &items) != napi_ok ||
+        !(items >= 0 && items <= 9007199254740991.0))) {
+      napi_throw_range_error(env, NULL, "expectedItems must be >= 0");
+      return NULL;
+   }
+   type = napi_undefined;
+   if (argc > 1) {
+      napi_typeof(env, args[1], &type);
+   }
+   if (type != napi_undefined &&
+       get_seed_value(env, args[1], KEY_SEED64, &seed) != ADDON_OK) {
+      return NULL;
+   }
+
+   obj = alloc_set(env, items);
+   if (obj == NULL) {
+      return NULL;
+   }
+   obj->seed_ = seed;
+   napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+   return jsthis;
+}
+
+/* add(key) returns whether key was new to the set; has(key) whether it is
+ * in the set. */
+static napi_value for_one(napi_env env, napi_callback_info info,
+                          int adding) {
+   size_t argc = 1;
+   napi_value args[1];
+   napi_value jsthis;
+   napi_value result;
+   Input_t input;
+   XXH3HashSet_Wrapper_t *s;
+   uint64_t fp;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc < 1) {
+      napi_throw_range_error(env, NULL, "One param is expected");
+      return NULL;
+   }
+   if (get_input(env, args[0], &input) != ADDON_OK) {
+      return NULL;
+   }
+   napi_unwrap(env, jsthis, (void **)&s);
+   fp = fingerprint(XXH3_64bits_withSeed(input.data_, input.len_, s->seed_));
+   RELEASE_INPUT(input)
+   if (adding && reserve_one(env, s) != ADDON_OK) {
+      return NULL;
+   }
+   napi_get_boolean(env, adding ? insert(s, fp) : contains(s, fp), &result);
+   return result;
+}
+
+static napi_value add(napi_env env, napi_callback_info info) {
+   return for_one(env, info, 1);
+}
+
+static napi_value has(napi_env env, napi_callback_info info) {
+   return for_one(env, info, 0);
+}
+
+/* addMany(keys[, layout]) and hasMany(keys[, layout]) return a Uint8Array
+ * with the add() or has() result of every key, as 1 or 0. If the table
+ * cannot grow, addMany() throws with the keys before the failing one
+ * added. */
+static napi_value for_many(napi_env env, napi_callback_info info,
+                           int adding) {
+   size_t argc = 2;
+   napi_value args[2];
+   napi_value jsthis;
+   napi_value buffer;
+   napi_value result;
+   XXH3HashSet_Wrapper_t *s;
+   XXH64_hash_t *hashes;
+   unsigned char *out;
+   uint32_t count;
+   uint32_t i;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc < 1) {
+      napi_throw_range_error(env, NULL, "At least one param is expected");
+      return NULL;
+   }
+   napi_unwrap(env, jsthis, (void **)&s);
+   if (get_key_hashes(env, args[0], argc > 1 ? args[1] : NULL, s->seed_,
+                      &hashes, &count) != ADDON_OK) {
+      return NULL;
+   }
+   napi_create_arraybuffer(env, count, (void **)&out, &buffer);
+   for (i = 0; i < count; i++) {
+      if (i + MEMBERSHIP_PREFETCH < count) {
+         PREFETCH(bucket_of(s, hashes[i + MEMBERSHIP_PREFETCH]));
+      }
+      if (adding) {
+         if (reserve_one(env, s) != ADDON_OK) {
+            free(hashes);
+            return NULL;
+         }
+         out[i] = (unsigned char)insert(s, fingerprint(hashes[i]));
+      } else {
+         out[i] = (unsigned char)contains(s, fingerprint(hashes[i]));
+      }
+   }
+   free(hashes);
+   napi_create_typedarray(env, napi_uint8_array, count, buffer, 0, &result);
+   return result;
+}
+
+static napi_value add_many(napi_env env, napi_callback_info info) {
+   return for_many(env, info, 1);
+}
+
+static napi_value has_many(napi_env env, napi_callback_info info) {
+   return for_many(env, info, 0);
+}
+
+static napi_value get_size(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   napi_value result;
+   XXH3HashSet_Wrapper_t *s;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&s);
+   napi_create_double(env, (double)s->size_, &result);
+   return result;
+}
+
+static napi_value export_state(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   napi_value result = NULL;
+   XXH3HashSet_Wrapper_t *s;
+   unsigned char *start;
+   unsigned char *p;
+   uint64_t i;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&s);
+   p = open_state(env, STATE_HASHSET, HASHSET_STATE_FIELDS + s->size_ * 8,
+                  &result);
+   if (p == NULL) {
+      return NULL;
+   }
+   start = p - STATE_HEADER_SIZE;
+   p = put_u64(p, s->seed_);
+   p = put_u64(p, s->size_);
+   for (i = 0; i < s->buckets_ * HASHSET_BUCKET_SLOTS; i++) {
+      if (s->slots_[i] != 0) {
+         p = put_u64(p, s->slots_[i]);
+      }
+   }
+   seal_state(start, p);
+   return result;
+}
+
+/* XXH3HashSet.importState(state) rebuilds the table, so a state does not
+ * depend on the table layout of the set that exported it. */
+static napi_value import_state(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   Class_data_t *class_data;
+   XXH3HashSet_Wrapper_t *obj;
+   Input_t input;
+   const unsigned char *p;
+   size_t size;
+   XXH64_hash_t seed;
+   uint64_t count;
+   uint64_t fp;
+   uint64_t i;
+
+   napi_get_cb_info(env, info, &argc, args, NULL, (void **)&class_data);
+   p = open_import(env, argc < 1 ? NULL : args[0], STATE_HASHSET, &input,
+                   &size);
+   if (p == NULL) {
+      return NULL;
+   }
+   if (size < HASHSET_STATE_FIELDS) {
+      state_corrupt(env, &input);
+      return NULL;
+   }
+   seed = get_u64(&p);
+   count = get_u64(&p);
+   if ((size - HASHSET_STATE_FIELDS) / 8 != count ||
+       (size - HASHSET_STATE_FIELDS) % 8 != 0) {
+      state_corrupt(env, &input);
+      return NULL;
+   }
+   obj = alloc_set(env, (double)count);
+   if (obj == NULL) {
+      RELEASE_INPUT(input)
+      return NULL;
+   }
+   obj->seed_ = seed;
+   for (i = 0; i < count; i++) {
+      fp = get_u64(&p);
+      if (fp == 0 || !insert(obj, fp)) {
+         destroy(env, obj, NULL);
+         state_corrupt(env, &input);
+         return NULL;
+      }
+   }
+   RELEASE_INPUT(input)
+   return new_adopted_instance(env, class_data, obj, destroy);
+}
+
+napi_value init_XXH3HashSet(napi_env env, napi_value exports) {
+   Class_data_t *class_data = create_class_data(env);
+   napi_property_descriptor properties[] = {
+       {"add", NULL, add, NULL, NULL, NULL, napi_default, NULL},
+       {"has", NULL, has, NULL, NULL, NULL, napi_default, NULL},
+       {"addMany", NULL, add_many, NULL, NULL, NULL, napi_default, NULL},
+       {"hasMany", NULL, has_many, NULL, NULL, NULL, napi_default, NULL},
+       {"size", NULL, NULL, get_size, NULL, NULL, napi_default, NULL},
+       {"exportState", NULL, export_state, NULL, NULL, NULL, napi_default,
+        NULL},
+       {"importState", NULL, import_state, NULL, NULL, NULL, napi_static,
+        class_data}};
+   DEFINE_CLASS(XXH3HashSet, class_data)
+}
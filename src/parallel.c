@@ -0,0 +1,239 @@
+#include "xxhash_addon.h"
+
+#include <uv.h>
+
+/* Upper bound on worker threads per call, whatever the caller asks for. */
+#define PARALLEL_MAX_THREADS 256
+
+typedef struct {
+   unsigned int pending_;
+} Parallel_Call_t;
+
+typedef struct Parallel_Slice_s {
+   const unsigned char *data_;
+   size_t len_;
+   size_t chunk_size_;
+   size_t first_;
+   size_t last_;
+   size_t leaf_size_;
+   Leaf_hasher leaf_;
+   unsigned char *leaves_;
+   Parallel_Call_t *call_;
+   struct Parallel_Slice_s *next_;
+} Parallel_Slice_t;
+
+/* Worker threads are started on demand, as many as the largest call so far
+ * asked for besides its own thread, and then live as long as the process.
+ * They take slices off a FIFO shared by every call, under queue_lock. A
+ * caller queues its slices, hashes one itself and then helps with whatever
+ * is still queued, so calls from several JS threads at once, or workers that
+ * could not be started, never wait for a worker that will not come. */
+static uv_once_t queue_once = UV_ONCE_INIT;
+static uv_mutex_t queue_lock;
+static uv_cond_t slice_queued;
+static uv_cond_t slice_done;
+static Parallel_Slice_t *queue_head;
+static Parallel_Slice_t *queue_tail;
+static unsigned int worker_count;
+static int worker_failed;
+
+/* Hashes chunks [first_, last_) into their slots of the leaves array. Slices
+ * never share a slot, so workers need no locking. */
+static void hash_slice(Parallel_Slice_t *slice) {
+   size_t i;
+   size_t start;
+   size_t len;
+
+   for (i = slice->first_; i < slice->last_; i++) {
+      start = i * slice->chunk_size_;
+      len = slice->len_ - start < slice->chunk_size_ ? slice->len_ - start
+                                                     : slice->chunk_size_;
+      slice->leaf_(slice->data_ + start, len,
+                   slice->leaves_ + i * slice->leaf_size_);
+   }
+}
+
+/* Takes the oldest queued slice, hashes it and accounts for it. Called and
+ * returns with queue_lock held. */
+static void run_queued_slice(void) {
+   Parallel_Slice_t *slice = queue_head;
+
+   queue_head = slice->next_;
+   if (queue_head == NULL) {
+      queue_tail = NULL;
+   }
+   uv_mutex_unlock(&queue_lock);
+   hash_slice(slice);
+   uv_mutex_lock(&queue_lock);
+   if (--slice->call_->pending_ == 0) {
+      uv_cond_broadcast(&slice_done);
+   }
+}
+
+static void worker_main(void *arg) {
+   (void)arg;
+   uv_mutex_lock(&queue_lock);
+   for (;;) {
+      while (queue_head == NULL) {
+         uv_cond_wait(&slice_queued, &queue_lock);
+      }
+      run_queued_slice();
+   }
+}
+
+static void queue_init(void) {
+   uv_mutex_init(&queue_lock);
+   uv_cond_init(&slice_queued);
+   uv_cond_init(&slice_done);
+}
+
+/* Starts workers until there are count of them. Called with queue_lock
+ * held; gives up for good when the OS refuses a thread. */
+static void start_workers(unsigned int count) {
+   uv_thread_t tid;
+
+   while (worker_count < count && !worker_failed) {
+      if (uv_thread_create(&tid, worker_main, NULL) == 0) {
+         worker_count++;
+      } else {
+         worker_failed = 1;
+      }
+   }
+}
+
+/* The CPU count: the default thread count of hashParallel(). */
+unsigned int parallel_default_threads(void) {
+   static unsigned int cpu_count = 0;
+   uv_cpu_info_t *infos;
+   int count;
+
+   if (cpu_count == 0) {
+      if (uv_cpu_info(&infos, &count) == 0) {
+         uv_free_cpu_info(infos, count);
+         cpu_count = count > 0 ? (unsigned int)count : 1;
+      } else {
+         cpu_count = 1;
+      }
+   }
+   return cpu_count;
+}
+
+size_t parallel_chunk_count(size_t len, size_t chunk_size) {
+   return len == 0 ? 1 : (len - 1) / chunk_size + 1;
+}
+
+/* Hashes each chunk_size slice of data with leaf() into leaves, spreading
+ * contiguous runs of chunks over up to threads threads (the calling thread
+ * included). The result does not depend on the thread count. Blocks until
+ * every chunk is hashed. */
+void hash_parallel_leaves(const unsigned char *data, size_t len,
+                          size_t chunk_size, unsigned int threads,
+                          Leaf_hasher leaf, size_t leaf_size,
+                          unsigned char *leaves) {
+   size_t chunks = parallel_chunk_count(len, chunk_size);
+   Parallel_Slice_t slices[PARALLEL_MAX_THREADS];
+   Parallel_Call_t call;
+   unsigned int t;
+
+   if (threads > PARALLEL_MAX_THREADS) {
+      threads = PARALLEL_MAX_THREADS;
+   }
+   if (threads > chunks) {
+      threads = (unsigned int)chunks;
+   }
+   if (threads == 0) {
+      threads = 1;
+   }
+
+   for (t = 0; t < threads; t++) {
+      slices[t].data_ = data;
+      slices[t].len_ = len;
+      slices[t].chunk_size_ = chunk_size;
+      slices[t].first_ = chunks * t / threads;
+      slices[t].last_ = chunks * (t + 1) / threads;
+      slices[t].leaf_size_ = leaf_size;
+      slices[t].leaf_ = leaf;
+      slices[t].leaves_ = leaves;
+      slices[t].call_ = &call;
+      slices[t].next_ = t + 1 < threads ? &slices[t + 1] : NULL;
+   }
+   if (threads == 1) {
+      hash_slice(&slices[0]);
+      return;
+   }
+
+   /* Slice 0 runs here; the others go to the workers. */
+   uv_once(&queue_once, queue_init);
+   call.pending_ = threads - 1;
+   uv_mutex_lock(&queue_lock);
+   start_workers(threads - 1);
+   if (queue_tail == NULL) {
+      queue_head = &slices[1];
+   } else {
+      queue_tail->next_ = &slices[1];
+   }
+   queue_tail = &slices[threads - 1];
+   uv_cond_broadcast(&slice_queued);
+   uv_mutex_unlock(&queue_lock);
+
+   hash_slice(&slices[0]);
+
+   uv_mutex_lock(&queue_lock);
+   while (call.pending_ > 0) {
+      if (queue_head != NULL) {
+         run_queued_slice();
+      } else {
+         uv_cond_wait(&slice_done, &queue_lock);
+      }
+   }
+   uv_mutex_unlock(&queue_lock);
+}
+
+/* Parses the optional { chunkSize, threads } argument of hashParallel(). */
+ADDON_errorcode get_parallel_options(napi_env env, napi_value value,
+                                     size_t *chunk_size,
+                                     unsigned int *threads) {
+   napi_valuetype type = napi_undefined;
+   napi_value field;
+   bool has_field;
+   int64_t number;
+
+   *chunk_size = PARALLEL_DEFAULT_CHUNK_SIZE;
+   *threads = parallel_default_threads();
+   if (value != NULL) {
+      napi_typeof(env, value, &type);
+   }
+   if (type == napi_undefined) {
+      return ADDON_OK;
+   }
+   if (type != napi_object) {
+      napi_throw_type_error(env, NULL, "Options must be an object");
+      return ADDON_ERROR;
+   }
+
+   napi_has_named_property(env, value, "chunkSize", &has_field);
+   if (has_field) {
+      napi_get_named_property(env, value, "chunkSize", &field);
+      if (napi_get_value_int64(env, field, &number) != napi_ok ||
+          number < PARALLEL_MIN_CHUNK_SIZE) {
+         napi_throw_range_error(
+             env, NULL,
+             "chunkSize must be >= " QUOTE(PARALLEL_MIN_CHUNK_SIZE));
+         return ADDON_ERROR;
+      }
+      *chunk_size = (size_t)number;
+   }
+
+   napi_has_named_property(env, value, "threads", &has_field);
+   if (has_field) {
+      napi_get_named_property(env, value, "threads", &field);
+      if (napi_get_value_int64(env, field, &number) != napi_ok ||
+          number < 1) {
+         napi_throw_range_error(env, NULL, "threads must be >= 1");
+         return ADDON_ERROR;
+      }
+      *threads = number > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS
+                                               : (unsigned int)number;
+   }
+   return ADDON_OK;
+}
@@ -0,0 +1,43 @@
+#include "xxhash_addon.h"
+
+#include <uv.h>
+
+Pool_t pool_XXHash3_Wrapper_t;
+Pool_t pool_XXHash64_Wrapper_t;
+Pool_t pool_XXHash32_Wrapper_t;
+
+/* Constructors and finalizers run on the JS thread, but each worker thread
+ * has its own, so the pools are shared under one lock. */
+static uv_once_t pool_once = UV_ONCE_INIT;
+static uv_mutex_t pool_lock;
+
+static void pool_init(void) { uv_mutex_init(&pool_lock); }
+
+/* Returns a released wrapper whose state_ is allocated but not reset, or
+ * NULL when the pool is empty. */
+void *pool_get(Pool_t *pool) {
+   void *wrapper = NULL;
+
+   uv_once(&pool_once, pool_init);
+   uv_mutex_lock(&pool_lock);
+   if (pool->count_ > 0) {
+      wrapper = pool->items_[--pool->count_];
+   }
+   uv_mutex_unlock(&pool_lock);
+   return wrapper;
+}
+
+/* Keeps wrapper (and its state_) for reuse. Returns 0 when the pool is full
+ * and the caller must free both. */
+int pool_put(Pool_t *pool, void *wrapper) {
+   int kept = 0;
+
+   uv_once(&pool_once, pool_init);
+   uv_mutex_lock(&pool_lock);
+   if (pool->count_ < POOL_MAX) {
+      pool->items_[pool->count_++] = wrapper;
+      kept = 1;
+   }
+   uv_mutex_unlock(&pool_lock);
+   return kept;
+}
@@ -0,0 +1,320 @@
+/* Calls here are the real xxhash.c functions, which the rest of the addon
+ * reaches through the redirects in xxhash_addon.h. */
+#define SIMD_NO_REDIRECT
+#include "xxhash_addon.h"
+#include "simd.h"
+
+#include <uv.h>
+
+#if defined(__linux__) && defined(SIMD_SVE)
+#include <sys/auxv.h>
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#endif
+
+/* XXH3 hashes inputs of up to 240 bytes with straight-line code, the same on
+ * every CPU; only longer inputs and streaming updates run the stripe loop
+ * that the SIMD backends of simd.h vectorize. The backend is process-wide:
+ * the fastest one the CPU supports unless XXHASH_ADDON_SIMD names another,
+ * and setSimdBackend() may switch it at any time. Every backend computes the
+ * same hashes, so a switch racing with a worker thread only changes how fast
+ * that thread goes. */
+
+#define SIMD_ENV "XXHASH_ADDON_SIMD"
+#define SIMD_MIDSIZE_MAX 240
+
+#if !defined(SIMD_X86) && !defined(SIMD_NEON)
+/* Whatever kernel xxhash.c was compiled with, e.g. VSX on POWER. */
+static XXH64_hash_t default_long64(const void *input, size_t len,
+                                   XXH64_hash_t seed, const void *secret,
+                                   size_t secret_size) {
+   if (secret != NULL) {
+      return XXH3_64bits_withSecret(input, len, secret, secret_size);
+   }
+   return XXH3_64bits_withSeed(input, len, seed);
+}
+
+static XXH128_hash_t default_long128(const void *input, size_t len,
+                                     XXH64_hash_t seed, const void *secret,
+                                     size_t secret_size) {
+   if (secret != NULL) {
+      return XXH3_128bits_withSecret(input, len, secret, secret_size);
+   }
+   return XXH3_128bits_withSeed(input, len, seed);
+}
+
+static const Simd_backend_t simd_default = {
+    "default", NULL, default_long64, default_long128, XXH3_64bits_update};
+#endif
+
+/* Slowest first: the last supported one is the default. */
+static const Simd_backend_t *const backends[] = {
+    &simd_scalar,
+#ifdef SIMD_X86
+    &simd_sse2,
+    &simd_avx2,
+    &simd_avx512,
+#endif
+#ifdef SIMD_NEON
+    &simd_neon,
+#endif
+#ifdef SIMD_SVE
+    &simd_sve,
+#endif
+#if !defined(SIMD_X86) && !defined(SIMD_NEON)
+    &simd_default,
+#endif
+};
+
+#define BACKEND_COUNT (sizeof(backends) / sizeof(backends[0]))
+
+/* setSimdBackend() swaps active on a JS thread while threadpool and
+ * hashParallel() workers read it; backends are immutable, so a pointer
+ * store with release and a load with acquire order is all it takes. */
+static const Simd_backend_t *active;
+static const Simd_backend_t *fastest;
+static int env_rejected;
+static uv_once_t simd_once = UV_ONCE_INIT;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ACTIVE_LOAD()                                                         \
+   ((const Simd_backend_t *)_InterlockedCompareExchangePointer(               \
+       (void *volatile *)&active, NULL, NULL))
+#define ACTIVE_STORE(BACKEND)                                                 \
+   _InterlockedExchangePointer((void *volatile *)&active, (void *)(BACKEND))
+#else
+#define ACTIVE_LOAD() __atomic_load_n(&active, __ATOMIC_ACQUIRE)
+#define ACTIVE_STORE(BACKEND)                                                 \
+   __atomic_store_n(&active, (BACKEND), __ATOMIC_RELEASE)
+#endif
+
+#ifdef SIMD_SVE
+int simd_sve_supported(void) {
+#if defined(__linux__)
+   return (getauxval(AT_HWCAP) & HWCAP_SVE) != 0;
+#else
+   return 0;
+#endif
+}
+#endif
+
+static int is_supported(const Simd_backend_t *backend) {
+   return backend->supported_ == NULL || backend->supported_();
+}
+
+/* The supported backend called name, "auto" being the fastest; NULL if
+ * there is none. */
+static const Simd_backend_t *find_backend(const char *name) {
+   size_t i;
+
+   if (strcmp(name, "auto") == 0) {
+      return fastest;
+   }
+   for (i = 0; i < BACKEND_COUNT; i++) {
+      if (strcmp(name, backends[i]->name_) == 0) {
+         return is_supported(backends[i]) ? backends[i] : NULL;
+      }
+   }
+   return NULL;
+}
+
+static void simd_init(void) {
+   const Simd_backend_t *backend;
+   const char *env;
+   size_t i;
+
+   for (i = 0; i < BACKEND_COUNT; i++) {
+      if (is_supported(backends[i])) {
+         fastest = backends[i];
+      }
+   }
+   backend = fastest;
+   env = getenv(SIMD_ENV);
+   if (env != NULL && *env != '\0') {
+      backend = find_backend(env);
+      if (backend == NULL) {
+         env_rejected = 1;
+         backend = fastest;
+      }
+   }
+   ACTIVE_STORE(backend);
+}
+
+XXH64_hash_t simd_XXH3_64bits(const void *input, size_t len) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_64bits(input, len);
+   }
+   return ACTIVE_LOAD()->long64_(input, len, 0, NULL, 0);
+}
+
+XXH64_hash_t simd_XXH3_64bits_withSeed(const void *input, size_t len,
+                                       XXH64_hash_t seed) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_64bits_withSeed(input, len, seed);
+   }
+   return ACTIVE_LOAD()->long64_(input, len, seed, NULL, 0);
+}
+
+XXH64_hash_t simd_XXH3_64bits_withSecret(const void *input, size_t len,
+                                         const void *secret,
+                                         size_t secret_size) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_64bits_withSecret(input, len, secret, secret_size);
+   }
+   return ACTIVE_LOAD()->long64_(input, len, 0, secret, secret_size);
+}
+
+XXH64_hash_t simd_XXH3_64bits_withSecretandSeed(const void *input,
+                                                size_t len,
+                                                const void *secret,
+                                                size_t secret_size,
+                                                XXH64_hash_t seed) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_64bits_withSecretandSeed(input, len, secret, secret_size,
+                                           seed);
+   }
+   return ACTIVE_LOAD()->long64_(input, len, seed, secret, secret_size);
+}
+
+XXH128_hash_t simd_XXH3_128bits(const void *input, size_t len) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_128bits(input, len);
+   }
+   return ACTIVE_LOAD()->long128_(input, len, 0, NULL, 0);
+}
+
+XXH128_hash_t simd_XXH3_128bits_withSeed(const void *input, size_t len,
+                                         XXH64_hash_t seed) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_128bits_withSeed(input, len, seed);
+   }
+   return ACTIVE_LOAD()->long128_(input, len, seed, NULL, 0);
+}
+
+XXH128_hash_t simd_XXH3_128bits_withSecret(const void *input, size_t len,
+                                           const void *secret,
+                                           size_t secret_size) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_128bits_withSecret(input, len, secret, secret_size);
+   }
+   return ACTIVE_LOAD()->long128_(input, len, 0, secret, secret_size);
+}
+
+XXH128_hash_t simd_XXH3_128bits_withSecretandSeed(const void *input,
+                                                  size_t len,
+                                                  const void *secret,
+                                                  size_t secret_size,
+                                                  XXH64_hash_t seed) {
+   if (len <= SIMD_MIDSIZE_MAX) {
+      return XXH3_128bits_withSecretandSeed(input, len, secret, secret_size,
+                                            seed);
+   }
+   return ACTIVE_LOAD()->long128_(input, len, seed, secret, secret_size);
+}
+
+XXH128_hash_t simd_XXH128(const void *input, size_t len, XXH64_hash_t seed) {
+   return simd_XXH3_128bits_withSeed(input, len, seed);
+}
+
+XXH_errorcode simd_XXH3_64bits_update(XXH3_state_t *state, const void *input,
+                                      size_t len) {
+   return ACTIVE_LOAD()->update_(state, input, len);
+}
+
+XXH_errorcode simd_XXH3_128bits_update(XXH3_state_t *state,
+                                       const void *input, size_t len) {
+   return ACTIVE_LOAD()->update_(state, input, len);
+}
+
+static napi_value get_simd_backend(napi_env env, napi_callback_info info) {
+   napi_value result;
+
+   (void)info;
+   napi_create_string_utf8(env, ACTIVE_LOAD()->name_, NAPI_AUTO_LENGTH,
+                           &result);
+   return result;
+}
+
+static napi_value set_simd_backend(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   char name[16];
+   const Simd_backend_t *backend;
+
+   napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+   if (argc < 1 || napi_get_value_string_utf8(env, args[0], name,
+                                              sizeof(name), NULL) != napi_ok) {
+      napi_throw_type_error(env, NULL, "Backend must be a string");
+      return NULL;
+   }
+   backend = find_backend(name);
+   if (backend == NULL) {
+      napi_throw_range_error(env, NULL,
+                             "Unknown or unsupported SIMD backend");
+      return NULL;
+   }
+   ACTIVE_STORE(backend);
+   return get_simd_backend(env, info);
+}
+
+static napi_value list_simd_backends(napi_env env, napi_callback_info info) {
+   napi_value result;
+   napi_value name;
+   uint32_t count = 0;
+   size_t i;
+
+   (void)info;
+   napi_create_array(env, &result);
+   for (i = 0; i < BACKEND_COUNT; i++) {
+      if (is_supported(backends[i])) {
+         napi_create_string_utf8(env, backends[i]->name_, NAPI_AUTO_LENGTH,
+                                 &name);
+         napi_set_element(env, result, count++, name);
+      }
+   }
+   return result;
+}
+
+/* An unusable XXHASH_ADDON_SIMD is only a speed setting gone wrong, so it
+ * costs a process warning, not the module: hashing carries on with the
+ * fastest backend. */
+static void warn_env_rejected(napi_env env) {
+   napi_value global;
+   napi_value process;
+   napi_value emit_warning;
+   napi_value message;
+
+   napi_get_global(env, &global);
+   if (napi_get_named_property(env, global, "process", &process) !=
+           napi_ok ||
+       napi_get_named_property(env, process, "emitWarning",
+                               &emit_warning) != napi_ok) {
+      return;
+   }
+   napi_create_string_utf8(env,
+                           SIMD_ENV " names an unknown or unsupported SIMD "
+                                    "backend; using the fastest one",
+                           NAPI_AUTO_LENGTH, &message);
+   napi_call_function(env, process, emit_warning, 1, &message, NULL);
+}
+
+napi_value init_Simd(napi_env env, napi_value exports) {
+   napi_property_descriptor properties[] = {
+       {"getSimdBackend", NULL, get_simd_backend, NULL, NULL, NULL,
+        napi_default, NULL},
+       {"setSimdBackend", NULL, set_simd_backend, NULL, NULL, NULL,
+        napi_default, NULL},
+       {"listSimdBackends", NULL, list_simd_backends, NULL, NULL, NULL,
+        napi_default, NULL}};
+
+   uv_once(&simd_once, simd_init);
+   if (env_rejected) {
+      warn_env_rejected(env);
+   }
+   napi_define_properties(env, exports,
+                          sizeof(properties) / sizeof(properties[0]),
+                          properties);
+   return exports;
+}
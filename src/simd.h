@@ -0,0 +1,80 @@
+#ifndef XXHASH_ADDON_SIMD_H_
+#define XXHASH_ADDON_SIMD_H_
+
+/* The XXH3 long-input kernels, one backend per instruction set. Shared by
+ * simd.c and the simd_*.c kernel units; the latter include xxhash.h with
+ * XXH_INLINE_ALL first, so this header relies on xxhash.h only. */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define SIMD_X86 1
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && !defined(__AARCH64EB__)
+#define SIMD_NEON 1
+#endif
+
+/* long64_/long128_ hash an input of more than 240 bytes: with secret when it
+ * is not NULL, else with the secret derived from seed. update_ is
+ * XXH3_64bits_update(), which is also XXH3_128bits_update(). supported_ is
+ * NULL when every CPU of the architecture runs the backend. */
+typedef struct {
+   const char *name_;
+   int (*supported_)(void);
+   XXH64_hash_t (*long64_)(const void *input, size_t len, XXH64_hash_t seed,
+                           const void *secret, size_t secret_size);
+   XXH128_hash_t (*long128_)(const void *input, size_t len,
+                             XXH64_hash_t seed, const void *secret,
+                             size_t secret_size);
+   XXH_errorcode (*update_)(XXH3_state_t *state, const void *input,
+                            size_t len);
+} Simd_backend_t;
+
+extern const Simd_backend_t simd_scalar;
+#ifdef SIMD_X86
+extern const Simd_backend_t simd_sse2;
+extern const Simd_backend_t simd_avx2;
+extern const Simd_backend_t simd_avx512;
+#endif
+#ifdef SIMD_NEON
+extern const Simd_backend_t simd_neon;
+#endif
+#ifdef SIMD_SVE
+extern const Simd_backend_t simd_sve;
+int simd_sve_supported(void);
+#endif
+
+/* Defines simd_##NAME from the xxhash.h kernels ACC, SCRAMBLE and INIT,
+ * every function compiled for TARGET so that the kernels inline. */
+#define SIMD_BACKEND(NAME, TARGET, ACC, SCRAMBLE, INIT, SUPPORTED)            \
+   static TARGET XXH64_hash_t NAME##_long64(const void *input, size_t len,    \
+                                            XXH64_hash_t seed,                \
+                                            const void *secret,               \
+                                            size_t secret_size) {             \
+      if (secret != NULL) {                                                   \
+         return XXH3_hashLong_64b_internal(input, len, secret, secret_size,   \
+                                           ACC, SCRAMBLE);                    \
+      }                                                                       \
+      return XXH3_hashLong_64b_withSeed_internal(input, len, seed, ACC,       \
+                                                 SCRAMBLE, INIT);             \
+   }                                                                          \
+                                                                              \
+   static TARGET XXH128_hash_t NAME##_long128(const void *input, size_t len,  \
+                                              XXH64_hash_t seed,              \
+                                              const void *secret,             \
+                                              size_t secret_size) {           \
+      if (secret != NULL) {                                                   \
+         return XXH3_hashLong_128b_internal(                                  \
+             input, len, (const xxh_u8 *)secret, secret_size, ACC, SCRAMBLE); \
+      }                                                                       \
+      return XXH3_hashLong_128b_withSeed_internal(input, len, seed, ACC,      \
+                                                  SCRAMBLE, INIT);            \
+   }                                                                          \
+                                                                              \
+   static TARGET XXH_errorcode NAME##_update(XXH3_state_t *state,             \
+                                             const void *input, size_t len) { \
+      return XXH3_update(state, (const xxh_u8 *)input, len, ACC, SCRAMBLE);   \
+   }                                                                          \
+                                                                              \
+   const Simd_backend_t simd_##NAME = {#NAME, SUPPORTED, NAME##_long64,       \
+                                       NAME##_long128, NAME##_update};
+
+#endif
@@ -0,0 +1,17 @@
+/* The NEON kernels. NEON is part of the AArch64 baseline, so the backend
+ * needs no runtime check; it is built apart from xxhash.c to stay available
+ * whatever XXH_VECTOR the toolchain picks for the rest of the addon. */
+#if (defined(__aarch64__) || defined(_M_ARM64)) && !defined(__AARCH64EB__)
+
+#define XXH_INLINE_ALL
+#define XXH_VECTOR XXH_NEON
+#include "xxhash.h"
+
+#include "simd.h"
+
+SIMD_BACKEND(neon, , XXH3_accumulate_neon, XXH3_scrambleAcc_neon,
+             XXH3_initCustomSecret_scalar, NULL)
+
+#else
+typedef int simd_neon_unused_t;
+#endif
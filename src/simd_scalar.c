@@ -0,0 +1,9 @@
+/* The portable kernels, which every CPU runs. */
+#define XXH_INLINE_ALL
+#define XXH_VECTOR XXH_SCALAR
+#include "xxhash.h"
+
+#include "simd.h"
+
+SIMD_BACKEND(scalar, , XXH3_accumulate_scalar, XXH3_scrambleAcc_scalar,
+             XXH3_initCustomSecret_scalar, NULL)
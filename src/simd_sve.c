@@ -0,0 +1,16 @@
+/* The SVE kernels. binding.gyp builds this file alone with SVE enabled, so
+ * nothing here runs before simd_sve_supported() says the CPU has SVE. */
+#if defined(__ARM_FEATURE_SVE)
+
+#define XXH_INLINE_ALL
+#define XXH_VECTOR XXH_SVE
+#include "xxhash.h"
+
+#include "simd.h"
+
+SIMD_BACKEND(sve, , XXH3_accumulate_sve, XXH3_scrambleAcc_scalar,
+             XXH3_initCustomSecret_scalar, simd_sve_supported)
+
+#else
+typedef int simd_sve_unused_t;
+#endif
@@ -0,0 +1,109 @@
+/* SSE2, AVX2 and AVX-512 kernels, each compiled for its own instruction set
+ * with a target attribute and only run once CPUID (and, for the wider
+ * registers, XGETBV: the OS must save them) reports it. */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define XXH_TARGET_SSE2 __attribute__((__target__("sse2")))
+#define XXH_TARGET_AVX2 __attribute__((__target__("avx2")))
+#define XXH_TARGET_AVX512 __attribute__((__target__("avx512f")))
+#else
+#define XXH_TARGET_SSE2
+#define XXH_TARGET_AVX2
+#define XXH_TARGET_AVX512
+#endif
+
+#define XXH_INLINE_ALL
+#define XXH_X86DISPATCH
+#define XXH_DISPATCH_AVX2 1
+#define XXH_DISPATCH_AVX512 1
+#include "xxhash.h"
+
+#include "simd.h"
+
+/* XCR0 bits: SSE and AVX state, then the AVX-512 opmask and upper ZMM. */
+#define XCR0_AVX 0x06
+#define XCR0_AVX512 0xE6
+
+static void cpuid(uint32_t leaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+   int r[4];
+
+   __cpuidex(r, (int)leaf, 0);
+   regs[0] = (uint32_t)r[0];
+   regs[1] = (uint32_t)r[1];
+   regs[2] = (uint32_t)r[2];
+   regs[3] = (uint32_t)r[3];
+#else
+   __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t xgetbv(void) {
+#if defined(_MSC_VER)
+   return _xgetbv(0);
+#else
+   uint32_t eax;
+   uint32_t edx;
+
+   __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+   return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+/* Leaf 7 EBX when the CPU has AVX and the OS saves the registers in mask,
+ * else 0. */
+static uint32_t avx_features(uint64_t mask) {
+   uint32_t regs[4];
+
+   cpuid(0, regs);
+   if (regs[0] < 7) {
+      return 0;
+   }
+   cpuid(1, regs);
+   /* OSXSAVE and AVX. */
+   if ((regs[2] & (3u << 27)) != (3u << 27) || (xgetbv() & mask) != mask) {
+      return 0;
+   }
+   cpuid(7, regs);
+   return regs[1];
+}
+
+static int sse2_supported(void) {
+   uint32_t regs[4];
+
+   cpuid(1, regs);
+   return (regs[3] >> 26) & 1;
+}
+
+static int avx2_supported(void) {
+   return (avx_features(XCR0_AVX) >> 5) & 1;
+}
+
+static int avx512_supported(void) {
+   return (avx_features(XCR0_AVX512) >> 16) & 1;
+}
+
+SIMD_BACKEND(sse2, XXH_TARGET_SSE2, XXH3_accumulate_sse2,
+             XXH3_scrambleAcc_sse2, XXH3_initCustomSecret_sse2,
+             sse2_supported)
+SIMD_BACKEND(avx2, XXH_TARGET_AVX2, XXH3_accumulate_avx2,
+             XXH3_scrambleAcc_avx2, XXH3_initCustomSecret_avx2,
+             avx2_supported)
+SIMD_BACKEND(avx512, XXH_TARGET_AVX512, XXH3_accumulate_avx512,
+             XXH3_scrambleAcc_avx512, XXH3_initCustomSecret_avx512,
+             avx512_supported)
+
+#else
+typedef int simd_x86_unused_t;
+#endif
@@ -0,0 +1,336 @@
+#include "xxhash_addon.h"
+
+/* Layout of an exported state. Integers are little-endian whatever the
+ * host, so a state can be resumed on any machine:
+ *
+ *   magic "XXHS" | version u8 | algorithm u8 | reserved u16 (zero)
+ *   payload, per algorithm (see the export functions below)
+ *   checksum u64, XXH3_64bits() of everything before it
+ *
+ * Buffers of pending input are copied byte for byte. importState() checks
+ * the header, the checksum, the exact length and every field that bounds
+ * memory access, so a damaged or foreign state is rejected rather than
+ * resumed into a wrong digest. */
+#define STATE_VERSION 1
+#define STATE_CHECKSUM_SIZE 8
+#define STATE_SIZE_XXH32 (4 + 4 + 4 + 4 * 4 + 4 + 16)
+#define STATE_SIZE_XXH64 (8 + 8 + 4 * 8 + 4 + 32)
+#define STATE_SIZE_XXH3                                                       \
+   (8 + 4 + 8 * 8 + 8 + 8 + 4 + XXH3_INTERNALBUFFER_SIZE)
+
+static const unsigned char state_magic[4] = {'X', 'X', 'H', 'S'};
+
+unsigned char *put_u32(unsigned char *p, XXH32_hash_t value) {
+   p[0] = (unsigned char)value;
+   p[1] = (unsigned char)(value >> 8);
+   p[2] = (unsigned char)(value >> 16);
+   p[3] = (unsigned char)(value >> 24);
+   return p + 4;
+}
+
+unsigned char *put_u64(unsigned char *p, XXH64_hash_t value) {
+   p = put_u32(p, (XXH32_hash_t)value);
+   return put_u32(p, (XXH32_hash_t)(value >> 32));
+}
+
+static unsigned char *put_bytes(unsigned char *p, const void *src,
+                                size_t len) {
+   memcpy(p, src, len);
+   return p + len;
+}
+
+XXH32_hash_t get_u32(const unsigned char **p) {
+   const unsigned char *q = *p;
+   *p += 4;
+   return (XXH32_hash_t)q[0] | (XXH32_hash_t)q[1] << 8 |
+          (XXH32_hash_t)q[2] << 16 | (XXH32_hash_t)q[3] << 24;
+}
+
+XXH64_hash_t get_u64(const unsigned char **p) {
+   XXH64_hash_t low = get_u32(p);
+   return low | (XXH64_hash_t)get_u32(p) << 32;
+}
+
+static void get_bytes(const unsigned char **p, void *dst, size_t len) {
+   memcpy(dst, *p, len);
+   *p += len;
+}
+
+/* Allocates the result Buffer and writes the header; the caller writes
+ * payload_size bytes at the returned pointer, then calls seal_state(). */
+unsigned char *open_state(napi_env env, STATE_algorithm algorithm,
+                          size_t payload_size, napi_value *result) {
+   unsigned char *data;
+
+   if (napi_create_buffer(env,
+                          STATE_HEADER_SIZE + payload_size +
+                              STATE_CHECKSUM_SIZE,
+                          (void **)&data, result) != napi_ok) {
+      return NULL;
+   }
+   data = put_bytes(data, state_magic, sizeof(state_magic));
+   *data++ = STATE_VERSION;
+   *data++ = (unsigned char)algorithm;
+   *data++ = 0;
+   *data++ = 0;
+   return data;
+}
+
+void seal_state(unsigned char *start, unsigned char *end) {
+   put_u64(end, XXH3_64bits(start, (size_t)(end - start)));
+}
+
+/* Returns the payload of a state exported for algorithm, or NULL with an
+ * exception pending. *payload_size is what lies between header and
+ * checksum; the caller still checks it against the algorithm's layout. */
+const unsigned char *open_import(napi_env env, napi_value value,
+                                 STATE_algorithm algorithm, Input_t *input,
+                                 size_t *payload_size) {
+   const unsigned char *data;
+   const unsigned char *end;
+   const char *error = NULL;
+
+   if (value == NULL) {
+      napi_throw_type_error(env, NULL, "State must be a Buffer");
+      return NULL;
+   }
+   if (get_input(env, value, input) != ADDON_OK) {
+      return NULL;
+   }
+   data = (const unsigned char *)input->data_;
+   if (input->len_ < STATE_HEADER_SIZE + STATE_CHECKSUM_SIZE ||
+       memcmp(data, state_magic, sizeof(state_magic)) != 0) {
+      error = "Invalid state: not an exported state";
+   } else if (data[4] != STATE_VERSION) {
+      error = "Invalid state: unsupported version";
+   } else if (data[5] != algorithm) {
+      error = "Invalid state: exported by a different class";
+   } else {
+      end = data + input->len_ - STATE_CHECKSUM_SIZE;
+      if (data[6] != 0 || data[7] != 0 ||
+          XXH3_64bits(data, (size_t)(end - data)) != get_u64(&end)) {
+         error = "Invalid state: checksum mismatch";
+      }
+   }
+   if (error != NULL) {
+      RELEASE_INPUT(*input)
+      napi_throw_error(env, NULL, error);
+      return NULL;
+   }
+   *payload_size = input->len_ - STATE_HEADER_SIZE - STATE_CHECKSUM_SIZE;
+   return data + STATE_HEADER_SIZE;
+}
+
+ADDON_errorcode state_corrupt(napi_env env, Input_t *input) {
+   RELEASE_INPUT(*input)
+   napi_throw_error(env, NULL, "Invalid state: corrupt fields");
+   return ADDON_ERROR;
+}
+
+/* XXH32 payload: seed u32 | total_len_32 u32 | large_len u32 | v u32[4] |
+ * memsize u32 | mem32 (16 bytes). */
+napi_value export_state32(napi_env env, const XXHash32_Wrapper_t *hasher,
+                          STATE_algorithm algorithm) {
+   const XXH32_state_t *state = hasher->state_;
+   napi_value result = NULL;
+   unsigned char *start;
+   unsigned char *p;
+   int i;
+
+   p = open_state(env, algorithm, STATE_SIZE_XXH32, &result);
+   if (p == NULL) {
+      return NULL;
+   }
+   start = p - STATE_HEADER_SIZE;
+   p = put_u32(p, hasher->seed_);
+   p = put_u32(p, state->total_len_32);
+   p = put_u32(p, state->large_len);
+   for (i = 0; i < 4; i++) {
+      p = put_u32(p, state->v[i]);
+   }
+   p = put_u32(p, state->memsize);
+   p = put_bytes(p, state->mem32, sizeof(state->mem32));
+   seal_state(start, p);
+   return result;
+}
+
+ADDON_errorcode import_state32(napi_env env, napi_value value,
+                               XXHash32_Wrapper_t *obj,
+                               STATE_algorithm algorithm) {
+   XXH32_state_t *state = obj->state_;
+   Input_t input;
+   const unsigned char *p;
+   size_t size;
+   int i;
+
+   p = open_import(env, value, algorithm, &input, &size);
+   if (p == NULL) {
+      return ADDON_ERROR;
+   }
+   if (size != STATE_SIZE_XXH32) {
+      return state_corrupt(env, &input);
+   }
+   obj->seed_ = get_u32(&p);
+   XXH32_reset(state, obj->seed_);
+   state->total_len_32 = get_u32(&p);
+   state->large_len = get_u32(&p);
+   for (i = 0; i < 4; i++) {
+      state->v[i] = get_u32(&p);
+   }
+   state->memsize = get_u32(&p);
+   get_bytes(&p, state->mem32, sizeof(state->mem32));
+   if (state->large_len > 1 || state->memsize >= sizeof(state->mem32)) {
+      return state_corrupt(env, &input);
+   }
+   RELEASE_INPUT(input)
+   return ADDON_OK;
+}
+
+/* XXH64 payload: seed u64 | total_len u64 | v u64[4] | memsize u32 |
+ * mem64 (32 bytes). */
+napi_value export_state64(napi_env env, const XXHash64_Wrapper_t *hasher,
+                          STATE_algorithm algorithm) {
+   const XXH64_state_t *state = hasher->state_;
+   napi_value result = NULL;
+   unsigned char *start;
+   unsigned char *p;
+   int i;
+
+   p = open_state(env, algorithm, STATE_SIZE_XXH64, &result);
+   if (p == NULL) {
+      return NULL;
+   }
+   start = p - STATE_HEADER_SIZE;
+   p = put_u64(p, hasher->seed_);
+   p = put_u64(p, state->total_len);
+   for (i = 0; i < 4; i++) {
+      p = put_u64(p, state->v[i]);
+   }
+   p = put_u32(p, state->memsize);
+   p = put_bytes(p, state->mem64, sizeof(state->mem64));
+   seal_state(start, p);
+   return result;
+}
+
+ADDON_errorcode import_state64(napi_env env, napi_value value,
+                               XXHash64_Wrapper_t *obj,
+                               STATE_algorithm algorithm) {
+   XXH64_state_t *state = obj->state_;
+   Input_t input;
+   const unsigned char *p;
+   size_t size;
+   int i;
+
+   p = open_import(env, value, algorithm, &input, &size);
+   if (p == NULL) {
+      return ADDON_ERROR;
+   }
+   if (size != STATE_SIZE_XXH64) {
+      return state_corrupt(env, &input);
+   }
+   obj->seed_ = get_u64(&p);
+   XXH64_reset(state, obj->seed_);
+   state->total_len = get_u64(&p);
+   for (i = 0; i < 4; i++) {
+      state->v[i] = get_u64(&p);
+   }
+   state->memsize = get_u32(&p);
+   get_bytes(&p, state->mem64, sizeof(state->mem64));
+   if (state->memsize >= sizeof(state->mem64)) {
+      return state_corrupt(env, &input);
+   }
+   RELEASE_INPUT(input)
+   return ADDON_OK;
+}
+
+/* XXH3 and XXH128 payload: seed u64 | secret size u32 (0 when seeded) |
+ * secret bytes | acc u64[8] | totalLen u64 | nbStripesSoFar u64 |
+ * bufferedSize u32 | buffer (256 bytes). The secret the seed derives is not
+ * stored; importing resets with the seed or secret first, which rebuilds it
+ * along with the other fields that follow from the key. */
+napi_value export_state3(napi_env env, const XXHash3_Wrapper_t *hasher,
+                         STATE_algorithm algorithm) {
+   const XXH3_state_t *state = hasher->state_;
+   napi_value result = NULL;
+   unsigned char *start;
+   unsigned char *p;
+   int i;
+
+   p = open_state(env, algorithm, STATE_SIZE_XXH3 + hasher->secretSize_,
+                  &result);
+   if (p == NULL) {
+      return NULL;
+   }
+   start = p - STATE_HEADER_SIZE;
+   p = put_u64(p, hasher->secret_ != NULL ? 0 : hasher->seed_);
+   p = put_u32(p, (XXH32_hash_t)hasher->secretSize_);
+   if (hasher->secret_ != NULL) {
+      p = put_bytes(p, hasher->secret_, hasher->secretSize_);
+   }
+   for (i = 0; i < 8; i++) {
+      p = put_u64(p, state->acc[i]);
+   }
+   p = put_u64(p, state->totalLen);
+   p = put_u64(p, state->nbStripesSoFar);
+   p = put_u32(p, state->bufferedSize);
+   p = put_bytes(p, state->buffer, sizeof(state->buffer));
+   seal_state(start, p);
+   return result;
+}
+
+/* The 64- and 128-bit resets are the same, so either class resets with the
+ * 64-bit one. */
+ADDON_errorcode import_state3(napi_env env, napi_value value,
+                              XXHash3_Wrapper_t *obj,
+                              STATE_algorithm algorithm) {
+   XXH3_state_t *state = obj->state_;
+   Input_t input;
+   const unsigned char *p;
+   size_t size;
+   size_t secret_size;
+   XXH64_hash_t stripes;
+   int i;
+
+   obj->secret_ = NULL;
+   obj->secretSize_ = 0;
+   p = open_import(env, value, algorithm, &input, &size);
+   if (p == NULL) {
+      return ADDON_ERROR;
+   }
+   if (size < STATE_SIZE_XXH3) {
+      return state_corrupt(env, &input);
+   }
+   obj->seed_ = get_u64(&p);
+   secret_size = get_u32(&p);
+   if (size != STATE_SIZE_XXH3 + secret_size ||
+       (secret_size != 0 && secret_size < XXH3_SECRET_SIZE_MIN)) {
+      return state_corrupt(env, &input);
+   }
+   if (secret_size == 0) {
+      XXH3_64bits_reset_withSeed(state, obj->seed_);
+   } else {
+      obj->secret_ = malloc(secret_size);
+      if (obj->secret_ == NULL) {
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+         return ADDON_ERROR;
+      }
+      get_bytes(&p, obj->secret_, secret_size);
+      obj->secretSize_ = secret_size;
+      XXH3_64bits_reset_withSecret(state, obj->secret_, secret_size);
+   }
+   for (i = 0; i < 8; i++) {
+      state->acc[i] = get_u64(&p);
+   }
+   state->totalLen = get_u64(&p);
+   stripes = get_u64(&p);
+   state->bufferedSize = get_u32(&p);
+   get_bytes(&p, state->buffer, sizeof(state->buffer));
+   if (stripes >= state->nbStripesPerBlock ||
+       state->bufferedSize > sizeof(state->buffer) ||
+       state->totalLen < state->bufferedSize) {
+      return state_corrupt(env, &input);
+   }
+   state->nbStripesSoFar = (size_t)stripes;
+   RELEASE_INPUT(input)
+   return ADDON_OK;
+}
@@ -0,0 +1,276 @@
+#include "xxhash_addon.h"
+
+#include <uv.h>
+
+/* Call statistics of the hot paths: per class and operation, how many calls
+ * and bytes, how the input sizes spread over log2 buckets and, for one call
+ * in sample_every, how long the call took, in log2 buckets of nanoseconds.
+ * Off unless XXHASH_ADDON_STATS is set or enableStats() is called; while off
+ * the macros of xxhash_addon.h test stats_enabled and nothing else. Counters
+ * and both switches are relaxed atomics, so worker threads of other
+ * environments may count into them too; a snapshot read, or a reset made,
+ * while calls are in flight is only roughly consistent. Batch, file,
+ * parallel and async calls are not counted. */
+
+#define STATS_ENV "XXHASH_ADDON_STATS"
+#define STATS_SIZE_BUCKETS 33
+#define STATS_LATENCY_BUCKETS 32
+
+typedef struct {
+   uint64_t calls_;
+   uint64_t bytes_;
+   /* sizes_[0] counts empty inputs, sizes_[i] those of 2^(i-1) up to
+    * 2^i - 1 bytes; the last bucket takes everything larger. */
+   uint64_t sizes_[STATS_SIZE_BUCKETS];
+   /* latency_[i] counts sampled calls of 2^(i-1) up to 2^i - 1 ns. */
+   uint64_t latency_[STATS_LATENCY_BUCKETS];
+} Stats_t;
+
+int stats_enabled;
+static uint32_t sample_every;
+static Stats_t counters[STATS_CLASS_COUNT][STATS_OP_COUNT];
+static uv_once_t stats_once = UV_ONCE_INIT;
+
+static const char *const class_names[STATS_CLASS_COUNT] = {
+    "XXH32", "XXH64", "XXH3", "XXH128"};
+static const char *const op_names[STATS_OP_COUNT] = {"hash", "update",
+                                                     "digest"};
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STATS_ADD(COUNTER, VALUE)                                             \
+   _InterlockedExchangeAdd64((volatile __int64 *)&(COUNTER),                  \
+                             (__int64)(VALUE))
+#define STATS_LOAD(COUNTER) (*(volatile uint64_t *)&(COUNTER))
+#define STATS_STORE(COUNTER, VALUE)                                           \
+   _InterlockedExchange64((volatile __int64 *)&(COUNTER), (__int64)(VALUE))
+/* The two switches, stats_enabled and sample_every, are 32 bits wide. */
+#define STATS_LOAD32(VAR) ((uint32_t)(*(volatile long *)&(VAR)))
+#define STATS_STORE32(VAR, VALUE)                                             \
+   _InterlockedExchange((volatile long *)&(VAR), (long)(VALUE))
+#else
+#define STATS_ADD(COUNTER, VALUE)                                             \
+   __atomic_fetch_add(&(COUNTER), (uint64_t)(VALUE), __ATOMIC_RELAXED)
+#define STATS_LOAD(COUNTER) __atomic_load_n(&(COUNTER), __ATOMIC_RELAXED)
+#define STATS_STORE(COUNTER, VALUE)                                           \
+   __atomic_store_n(&(COUNTER), (VALUE), __ATOMIC_RELAXED)
+#define STATS_LOAD32(VAR) STATS_LOAD(VAR)
+#define STATS_STORE32(VAR, VALUE) STATS_STORE(VAR, VALUE)
+#endif
+
+/* Index of the highest set bit plus one; 0 for 0. */
+static unsigned log2_bucket(uint64_t value, unsigned buckets) {
+   unsigned bucket = 0;
+
+   while (value != 0 && bucket < buckets - 1) {
+      value >>= 1;
+      bucket++;
+   }
+   return bucket;
+}
+
+/* Returns the start time when this call is to be timed, else 0. Sampling
+ * keys off a racy read of the call count, which is good enough to pick
+ * roughly one call in sample_every. */
+uint64_t stats_begin(STATS_class cls, STATS_op op) {
+   uint32_t every = STATS_LOAD32(sample_every);
+
+   if (every == 0 ||
+       STATS_LOAD(counters[cls][op].calls_) % every != 0) {
+      return 0;
+   }
+   return uv_hrtime();
+}
+
+void stats_end(STATS_class cls, STATS_op op, size_t len, uint64_t start) {
+   Stats_t *stats = &counters[cls][op];
+
+   STATS_ADD(stats->calls_, 1);
+   if (op != STATS_DIGEST) {
+      STATS_ADD(stats->bytes_, len);
+      STATS_ADD(stats->sizes_[log2_bucket(len, STATS_SIZE_BUCKETS)], 1);
+   }
+   if (start != 0) {
+      STATS_ADD(stats->latency_[log2_bucket(uv_hrtime() - start,
+                                            STATS_LATENCY_BUCKETS)],
+                1);
+   }
+}
+
+/* Parses a sampling interval: a whole number of at most 2^32 - 1. Returns
+ * ADDON_ERROR for anything else. */
+static ADDON_errorcode parse_sample_every(const char *text,
+                                          uint32_t *result) {
+   uint64_t value = 0;
+
+   if (*text == '\0') {
+      return ADDON_ERROR;
+   }
+   for (; *text != '\0'; text++) {
+      if (*text < '0' || *text > '9') {
+         return ADDON_ERROR;
+      }
+      value = value * 10 + (uint64_t)(*text - '0');
+      if (value > UINT32_MAX) {
+         return ADDON_ERROR;
+      }
+   }
+   *result = (uint32_t)value;
+   return ADDON_OK;
+}
+
+/* Any value other than "" and "0" turns statistics on; a number also sets
+ * the sampling interval. */
+static void stats_init(void) {
+   const char *env = getenv(STATS_ENV);
+   uint32_t every;
+
+   if (env == NULL || *env == '\0' || strcmp(env, "0") == 0) {
+      return;
+   }
+   if (parse_sample_every(env, &every) == ADDON_OK) {
+      STATS_STORE32(sample_every, every);
+   }
+   STATS_STORE32(stats_enabled, 1);
+}
+
+static napi_value create_buckets(napi_env env, const uint64_t *buckets,
+                                 size_t count) {
+   napi_value result;
+   napi_value value;
+   size_t i;
+
+   napi_create_array_with_length(env, count, &result);
+   for (i = 0; i < count; i++) {
+      napi_create_double(env, (double)STATS_LOAD(buckets[i]), &value);
+      napi_set_element(env, result, (uint32_t)i, value);
+   }
+   return result;
+}
+
+static napi_value create_op_stats(napi_env env, Stats_t *stats) {
+   napi_value result;
+   napi_value value;
+
+   napi_create_object(env, &result);
+   napi_create_double(env, (double)STATS_LOAD(stats->calls_), &value);
+   napi_set_named_property(env, result, "calls", value);
+   napi_create_double(env, (double)STATS_LOAD(stats->bytes_), &value);
+   napi_set_named_property(env, result, "bytes", value);
+   napi_set_named_property(
+       env, result, "sizes",
+       create_buckets(env, stats->sizes_, STATS_SIZE_BUCKETS));
+   napi_set_named_property(
+       env, result, "latencyNs",
+       create_buckets(env, stats->latency_, STATS_LATENCY_BUCKETS));
+   return result;
+}
+
+static napi_value get_stats(napi_env env, napi_callback_info info) {
+   napi_value result;
+   napi_value classes;
+   napi_value ops;
+   napi_value value;
+   int cls;
+   int op;
+
+   (void)info;
+   napi_create_object(env, &result);
+   napi_get_boolean(env, STATS_ENABLED() != 0, &value);
+   napi_set_named_property(env, result, "enabled", value);
+   napi_create_uint32(env, STATS_LOAD32(sample_every), &value);
+   napi_set_named_property(env, result, "sampleEvery", value);
+
+   napi_create_object(env, &classes);
+   for (cls = 0; cls < STATS_CLASS_COUNT; cls++) {
+      napi_create_object(env, &ops);
+      for (op = 0; op < STATS_OP_COUNT; op++) {
+         napi_set_named_property(env, ops, op_names[op],
+                                 create_op_stats(env, &counters[cls][op]));
+      }
+      napi_set_named_property(env, classes, class_names[cls], ops);
+   }
+   napi_set_named_property(env, result, "classes", classes);
+   return result;
+}
+
+/* Other threads may be counting meanwhile, so the counters are cleared one
+ * atomic store at a time rather than with memset(). */
+static void clear_buckets(uint64_t *buckets, size_t count) {
+   size_t i;
+
+   for (i = 0; i < count; i++) {
+      STATS_STORE(buckets[i], 0);
+   }
+}
+
+static napi_value reset_stats(napi_env env, napi_callback_info info) {
+   Stats_t *stats;
+   int cls;
+   int op;
+
+   (void)env;
+   (void)info;
+   for (cls = 0; cls < STATS_CLASS_COUNT; cls++) {
+      for (op = 0; op < STATS_OP_COUNT; op++) {
+         stats = &counters[cls][op];
+         STATS_STORE(stats->calls_, 0);
+         STATS_STORE(stats->bytes_, 0);
+         clear_buckets(stats->sizes_, STATS_SIZE_BUCKETS);
+         clear_buckets(stats->latency_, STATS_LATENCY_BUCKETS);
+      }
+   }
+   return NULL;
+}
+
+/* enableStats([sampleEvery]): sampleEvery 0 turns timing off, N times one
+ * call in N. Leaves the interval as it is when not given. */
+static napi_value enable_stats(napi_env env, napi_callback_info info) {
+   size_t argc = 1;
+   napi_value args[1];
+   napi_valuetype type = napi_undefined;
+   int64_t every;
+
+   napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+   if (argc > 0) {
+      napi_typeof(env, args[0], &type);
+   }
+   if (type != napi_undefined) {
+      if (napi_get_value_int64(env, args[0], &every) != napi_ok) {
+         napi_throw_type_error(env, NULL, "sampleEvery must be a number");
+         return NULL;
+      }
+      if (every < 0 || every > UINT32_MAX) {
+         napi_throw_range_error(env, NULL,
+                                "sampleEvery must be 0 to 2^32 - 1");
+         return NULL;
+      }
+      STATS_STORE32(sample_every, (uint32_t)every);
+   }
+   STATS_STORE32(stats_enabled, 1);
+   return NULL;
+}
+
+static napi_value disable_stats(napi_env env, napi_callback_info info) {
+   (void)env;
+   (void)info;
+   STATS_STORE32(stats_enabled, 0);
+   return NULL;
+}
+
+napi_value init_Stats(napi_env env, napi_value exports) {
+   napi_property_descriptor properties[] = {
+       {"getStats", NULL, get_stats, NULL, NULL, NULL, napi_default, NULL},
+       {"resetStats", NULL, reset_stats, NULL, NULL, NULL, napi_default,
+        NULL},
+       {"enableStats", NULL, enable_stats, NULL, NULL, NULL, napi_default,
+        NULL},
+       {"disableStats", NULL, disable_stats, NULL, NULL, NULL, napi_default,
+        NULL}};
+
+   uv_once(&stats_once, stats_init);
+   napi_define_properties(env, exports,
+                          sizeof(properties) / sizeof(properties[0]),
+                          properties);
+   return exports;
+}
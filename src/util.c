@@ -0,0 +1,581 @@
+#include "xxhash_addon.h"
+
+/* Resolves the byte range of a Buffer, any other TypedArray, a DataView or
+ * an ArrayBuffer, without throwing; ADDON_ERROR for anything else. The type
+ * is checked before the data is read because napi_get_buffer_info() aborts
+ * the process on a non-buffer in Node < 20. */
+ADDON_errorcode get_byte_range(napi_env env, napi_value value, void **data,
+                               size_t *len) {
+   /* By napi_typedarray_type, Int8Array to BigUint64Array. */
+   static const size_t element_sizes[] = {1, 1, 1, 2, 2, 4, 4, 4, 8, 8, 8};
+   bool is_type = false;
+   napi_typedarray_type type;
+   size_t length;
+
+   napi_is_buffer(env, value, &is_type);
+   if (is_type) {
+      napi_get_buffer_info(env, value, data, len);
+      return ADDON_OK;
+   }
+   napi_is_typedarray(env, value, &is_type);
+   if (is_type) {
+      napi_get_typedarray_info(env, value, &type, &length, data, NULL, NULL);
+      if ((size_t)type >= sizeof(element_sizes) / sizeof(element_sizes[0])) {
+         return ADDON_ERROR;
+      }
+      *len = length * element_sizes[type];
+      return ADDON_OK;
+   }
+   napi_is_dataview(env, value, &is_type);
+   if (is_type) {
+      napi_get_dataview_info(env, value, len, data, NULL, NULL);
+      return ADDON_OK;
+   }
+   napi_is_arraybuffer(env, value, &is_type);
+   if (is_type) {
+      napi_get_arraybuffer_info(env, value, data, len);
+      return ADDON_OK;
+   }
+   return ADDON_ERROR;
+}
+
+/* Resolves a data argument. Buffers, other TypedArrays, DataViews and
+ * ArrayBuffers are used in place, see get_byte_range(). A string is hashed
+ * as UTF-8, which V8 has to encode for us: short ones go to input->stack_,
+ * longer ones to a heap_ buffer of the exact size that the caller frees with
+ * RELEASE_INPUT. */
+ADDON_errorcode get_input(napi_env env, napi_value value, Input_t *input) {
+   napi_valuetype type = napi_undefined;
+   size_t units;
+   size_t size;
+
+   input->heap_ = NULL;
+   if (get_byte_range(env, value, &input->data_, &input->len_) ==
+       ADDON_OK) {
+      return ADDON_OK;
+   }
+
+   napi_typeof(env, value, &type);
+   if (type == napi_string) {
+      napi_get_value_string_utf16(env, value, NULL, 0, &units);
+      if (units < INPUT_STACK_SIZE / 3) {
+         napi_get_value_string_utf8(env, value, input->stack_,
+                                    INPUT_STACK_SIZE, &input->len_);
+         input->data_ = input->stack_;
+         return ADDON_OK;
+      }
+      napi_get_value_string_utf8(env, value, NULL, 0, &size);
+      input->heap_ = malloc(size + 1);
+      if (input->heap_ == NULL) {
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+         return ADDON_ERROR;
+      }
+      napi_get_value_string_utf8(env, value, input->heap_, size + 1,
+                                 &input->len_);
+      input->data_ = input->heap_;
+      return ADDON_OK;
+   }
+
+   napi_throw_type_error(env, NULL,
+                         "Input must be a string, Buffer, TypedArray, "
+                         "DataView or ArrayBuffer");
+   return ADDON_ERROR;
+}
+
+/* Reads a number or BigInt seed. Numbers must be safe integers; both must
+ * fit the seed width of kind. */
+ADDON_errorcode get_seed_value(napi_env env, napi_value value, KEY_kind kind,
+                               XXH64_hash_t *seed) {
+   napi_valuetype type = napi_undefined;
+   uint64_t max = kind == KEY_SEED32 ? UINT32_MAX : UINT64_MAX;
+   double number;
+   bool lossless = false;
+
+   napi_typeof(env, value, &type);
+   if (type == napi_number) {
+      napi_get_value_double(env, value, &number);
+      if (number >= 0 && number <= 9007199254740991.0 &&
+          number == (double)(uint64_t)number && (uint64_t)number <= max) {
+         *seed = (uint64_t)number;
+         return ADDON_OK;
+      }
+   } else if (type == napi_bigint) {
+      napi_get_value_bigint_uint64(env, value, seed, &lossless);
+      if (lossless && *seed <= max) {
+         return ADDON_OK;
+      }
+   } else {
+      napi_throw_type_error(env, NULL, "Seed must be a number or BigInt");
+      return ADDON_ERROR;
+   }
+   napi_throw_range_error(env, NULL,
+                          kind == KEY_SEED32
+                              ? "Seed must be an integer in [0, 2^32)"
+                              : "Seed must be an integer in [0, 2^64)");
+   return ADDON_ERROR;
+}
+
+/* Resolves the seedOrSecret argument of hash(). undefined means seed 0; a
+ * number or BigInt is the seed itself; a 4- or 8-byte Buffer is a canonical
+ * seed and a longer one a secret, as in the constructors. An XXH3Secret is
+ * taken as is. Secrets are referenced in place, never copied. */
+ADDON_errorcode get_hash_key(napi_env env, napi_value value, KEY_kind kind,
+                             Hash_key_t *key) {
+   napi_valuetype type = napi_undefined;
+   XXH3Secret_Wrapper_t *secret;
+   void *data;
+   size_t len;
+
+   key->seed_ = 0;
+   key->secret_ = NULL;
+   key->secretSize_ = 0;
+   key->fromSeed_ = 0;
+   if (value != NULL) {
+      napi_typeof(env, value, &type);
+   }
+   if (type == napi_undefined) {
+      return ADDON_OK;
+   }
+   if (type == napi_number || type == napi_bigint) {
+      return get_seed_value(env, value, kind, &key->seed_);
+   }
+
+   if (kind == KEY_SEED_OR_SECRET &&
+       (secret = get_xxh3_secret(env, value)) != NULL) {
+      key->seed_ = secret->seed_;
+      key->secret_ = secret->secret_;
+      key->secretSize_ = secret->secretSize_;
+      key->fromSeed_ = secret->fromSeed_;
+      return ADDON_OK;
+   }
+   if (get_byte_range(env, value, &data, &len) == ADDON_OK) {
+      if (len == 4) {
+         key->seed_ = XXH32_hashFromCanonical((XXH32_canonical_t *)data);
+         return ADDON_OK;
+      }
+      if (len == 8 && kind != KEY_SEED32) {
+         key->seed_ = XXH64_hashFromCanonical((XXH64_canonical_t *)data);
+         return ADDON_OK;
+      }
+      if (len >= XXH3_SECRET_SIZE_MIN && kind == KEY_SEED_OR_SECRET) {
+         key->secret_ = data;
+         key->secretSize_ = len;
+         return ADDON_OK;
+      }
+      if (kind == KEY_SEED32) {
+         napi_throw_error(env, NULL, "Seed must be 4 bytes");
+      } else if (kind == KEY_SEED64) {
+         napi_throw_error(env, NULL, "Seed must be 4 or 8 bytes");
+      } else {
+         napi_throw_error(
+             env, NULL,
+             "Secret must be >= " QUOTE(XXH3_SECRET_SIZE_MIN) " bytes");
+      }
+      return ADDON_ERROR;
+   }
+
+   napi_throw_type_error(env, NULL,
+                         kind == KEY_SEED_OR_SECRET
+                             ? "Seed must be a number, BigInt, Buffer or "
+                               "XXH3Secret"
+                             : "Seed must be a number, BigInt or Buffer");
+   return ADDON_ERROR;
+}
+
+static void free_class_data(void *arg) {
+   Class_data_t *data = (Class_data_t *)arg;
+   if (data->cons_ != NULL) {
+      napi_delete_reference(data->env_, data->cons_);
+   }
+   free(data);
+}
+
+/* Allocates the per-env Class_data_t of a hasher class. It outlives every
+ * call into the class and is freed when the env is torn down. */
+Class_data_t *create_class_data(napi_env env) {
+   Class_data_t *data = calloc(1, sizeof(Class_data_t));
+
+   if (data == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   data->env_ = env;
+   napi_add_env_cleanup_hook(env, free_class_data, data);
+   return data;
+}
+
+/* Runs the constructor of class_data's class with obj set as adopted_, for
+ * it to wrap as is rather than build an object from arguments. If the
+ * constructor throws before taking obj, obj is released with destroy. */
+napi_value new_adopted_instance(napi_env env, Class_data_t *class_data,
+                                void *obj, napi_finalize destroy) {
+   napi_value cons;
+   napi_value result = NULL;
+
+   napi_get_reference_value(env, class_data->cons_, &cons);
+   class_data->adopted_ = obj;
+   napi_new_instance(env, cons, 0, NULL, &result);
+   if (class_data->adopted_ != NULL) {
+      class_data->adopted_ = NULL;
+      destroy(env, obj, NULL);
+   }
+   return result;
+}
+
+/* Resolves out[offset] for digestInto()/hashInto(), checking that
+ * digest_size bytes fit there. On success *end is set to the offset just
+ * past the digest; on failure NULL is returned with an exception pending. */
+void *get_into_target(napi_env env, napi_value out, napi_value offset,
+                      size_t digest_size, napi_value *end) {
+   napi_valuetype offset_type = napi_undefined;
+   void *out_data;
+   size_t out_len;
+   double number = 0;
+   size_t start;
+
+   if (get_byte_range(env, out, &out_data, &out_len) != ADDON_OK) {
+      napi_throw_type_error(env, NULL, "Output is not a buffer");
+      return NULL;
+   }
+   if (offset != NULL) {
+      napi_typeof(env, offset, &offset_type);
+   }
+   if (offset_type != napi_undefined &&
+       napi_get_value_double(env, offset, &number) != napi_ok) {
+      napi_throw_type_error(env, NULL, "Offset must be a number");
+      return NULL;
+   }
+   if (!(number >= 0 && number <= 9007199254740991.0 &&
+         number == (double)(uint64_t)number)) {
+      napi_throw_range_error(env, NULL, "Offset must be an integer >= 0");
+      return NULL;
+   }
+   if (number > (double)out_len ||
+       out_len - (size_t)number < digest_size) {
+      napi_throw_range_error(env, NULL, "Output is too small");
+      return NULL;
+   }
+   start = (size_t)number;
+   napi_create_double(env, (double)(start + digest_size), end);
+   return (char *)out_data + start;
+}
+
+/* Validates an offsets array for hashBatch(data, offsets). It must be a
+ * Uint32Array of count + 1 non-decreasing boundaries within data_len. */
+ADDON_errorcode get_batch_offsets(napi_env env, napi_value value,
+                                  size_t data_len, const uint32_t **offsets,
+                                  uint32_t *count) {
+   bool is_typedarray = false;
+   napi_typedarray_type type;
+   size_t length;
+   void *raw;
+   const uint32_t *offs;
+   size_t i;
+
+   napi_is_typedarray(env, value, &is_typedarray);
+   if (!is_typedarray) {
+      napi_throw_type_error(env, NULL, "Offsets must be a Uint32Array");
+      return ADDON_ERROR;
+   }
+   napi_get_typedarray_info(env, value, &type, &length, &raw, NULL, NULL);
+   if (type != napi_uint32_array) {
+      napi_throw_type_error(env, NULL, "Offsets must be a Uint32Array");
+      return ADDON_ERROR;
+   }
+   if (length == 0) {
+      *offsets = NULL;
+      *count = 0;
+      return ADDON_OK;
+   }
+
+   offs = (const uint32_t *)raw;
+   for (i = 1; i < length; i++) {
+      if (offs[i] < offs[i - 1]) {
+         napi_throw_range_error(env, NULL, "Offsets must be non-decreasing");
+         return ADDON_ERROR;
+      }
+   }
+   if (offs[length - 1] > data_len) {
+      napi_throw_range_error(env, NULL, "Offsets exceed the data buffer");
+      return ADDON_ERROR;
+   }
+
+   *offsets = offs;
+   *count = (uint32_t)(length - 1);
+   return ADDON_OK;
+}
+
+/* Hashes the keys of addMany()/hasMany() with XXH3_64bits_withSeed() into
+ * a malloc()ed array the caller frees. keys is an array of inputs, or one
+ * buffer that layout splits: a Uint32Array of offsets as in hashBatch(), or
+ * a number, the width of every key. */
+ADDON_errorcode get_key_hashes(napi_env env, napi_value keys,
+                               napi_value layout, XXH64_hash_t seed,
+                               XXH64_hash_t **hashes, uint32_t *count) {
+   napi_valuetype layout_type = napi_undefined;
+   bool is_array = false;
+   napi_value elem;
+   Input_t input;
+   const uint32_t *offsets;
+   const unsigned char *data;
+   void *raw;
+   size_t len;
+   uint32_t width = 0;
+   uint32_t i;
+
+   napi_is_array(env, keys, &is_array);
+   if (is_array) {
+      napi_get_array_length(env, keys, count);
+   } else if (get_byte_range(env, keys, &raw, &len) != ADDON_OK) {
+      napi_throw_type_error(env, NULL, "Keys must be an array or a buffer");
+      return ADDON_ERROR;
+   } else {
+      if (layout != NULL) {
+         napi_typeof(env, layout, &layout_type);
+      }
+      if (layout_type == napi_number) {
+         if (napi_get_value_uint32(env, layout, &width) != napi_ok ||
+             width == 0 || len % width != 0 || len / width > UINT32_MAX) {
+            napi_throw_range_error(
+                env, NULL, "Key width must divide the buffer length");
+            return ADDON_ERROR;
+         }
+         offsets = NULL;
+         *count = (uint32_t)(len / width);
+      } else if (get_batch_offsets(env, layout, len, &offsets, count) !=
+                 ADDON_OK) {
+         return ADDON_ERROR;
+      }
+   }
+
+   *hashes = malloc(*count > 0 ? *count * sizeof(XXH64_hash_t) : 1);
+   if (*hashes == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return ADDON_ERROR;
+   }
+   if (is_array) {
+      for (i = 0; i < *count; i++) {
+         napi_get_element(env, keys, i, &elem);
+         if (get_input(env, elem, &input) != ADDON_OK) {
+            free(*hashes);
+            return ADDON_ERROR;
+         }
+         (*hashes)[i] = XXH3_64bits_withSeed(input.data_, input.len_, seed);
+         RELEASE_INPUT(input)
+      }
+   } else {
+      data = (const unsigned char *)raw;
+      for (i = 0; i < *count; i++) {
+         (*hashes)[i] =
+             offsets != NULL
+                 ? XXH3_64bits_withSeed(data + offsets[i],
+                                        offsets[i + 1] - offsets[i], seed)
+                 : XXH3_64bits_withSeed(data + (size_t)i * width, width,
+                                        seed);
+      }
+   }
+   return ADDON_OK;
+}
+
+/* Allocates size zeroed bytes on a cache-line boundary for the tables of
+ * the membership classes. *base is what to free(); NULL is returned when
+ * out of memory. */
+void *calloc_lines(size_t size, void **base) {
+   *base = size <= SIZE_MAX - CACHE_LINE_SIZE
+               ? calloc(1, size + CACHE_LINE_SIZE - 1)
+               : NULL;
+   if (*base == NULL) {
+      return NULL;
+   }
+   return (void *)(((uintptr_t)*base + CACHE_LINE_SIZE - 1) &
+                   ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+}
+
+/* Resolves where hashBatch writes its digests. With no (or an undefined) out
+ * argument a new Buffer of canonical digests is allocated. A caller-provided
+ * Buffer receives canonical digests too; a typed array of lane_type receives
+ * native hash values instead. */
+ADDON_errorcode get_batch_output(napi_env env, napi_value value,
+                                 uint32_t count, size_t digest_size,
+                                 napi_typedarray_type lane_type,
+                                 unsigned char **out, int *canonical,
+                                 napi_value *result) {
+   napi_valuetype value_type = napi_undefined;
+   bool is_typedarray = false;
+   napi_typedarray_type type;
+   size_t length;
+   size_t needed = (size_t)count * digest_size;
+   void *data;
+
+   if (value != NULL) {
+      napi_typeof(env, value, &value_type);
+   }
+   if (value_type == napi_undefined) {
+      napi_create_buffer(env, needed, (void **)out, result);
+      *canonical = 1;
+      return ADDON_OK;
+   }
+
+   /* napi_is_buffer() accepts any ArrayBufferView, so look at the element
+    * type instead: Uint8Array (incl. Buffer) gets canonical digests. */
+   napi_is_typedarray(env, value, &is_typedarray);
+   if (!is_typedarray) {
+      napi_throw_type_error(env, NULL, "Output must be a buffer or array");
+      return ADDON_ERROR;
+   }
+   napi_get_typedarray_info(env, value, &type, &length, &data, NULL, NULL);
+   if (type == napi_uint8_array) {
+      *canonical = 1;
+   } else if (type == lane_type) {
+      length *= lane_type == napi_uint32_array ? 4 : 8;
+      *canonical = 0;
+   } else {
+      napi_throw_type_error(env, NULL,
+                            lane_type == napi_uint32_array
+                                ? "Output must be a buffer or Uint32Array"
+                                : "Output must be a buffer or BigUint64Array");
+      return ADDON_ERROR;
+   }
+   if (length < needed) {
+      napi_throw_range_error(env, NULL, "Output is too small");
+      return ADDON_ERROR;
+   }
+
+   *out = (unsigned char *)data;
+   *result = value;
+   return ADDON_OK;
+}
+
+static void async_work_free(napi_env env, Async_Work_t *work) {
+   if (work->data_ref_ != NULL) {
+      napi_delete_reference(env, work->data_ref_);
+   }
+   if (work->this_ref_ != NULL) {
+      napi_delete_reference(env, work->this_ref_);
+   }
+   if (work->work_ != NULL) {
+      napi_delete_async_work(env, work->work_);
+   }
+   free(work->owned_);
+   free(work->path_);
+   free(work);
+}
+
+/* Rejects the Promise of work, not yet queued, with the pending exception
+ * and frees work: async calls report bad arguments through their Promise
+ * rather than by throwing. The caller still returns the Promise. */
+void async_work_reject(napi_env env, Async_Work_t *work) {
+   napi_value error;
+
+   napi_get_and_clear_last_exception(env, &error);
+   napi_reject_deferred(env, work->deferred_, error);
+   async_work_free(env, work);
+}
+
+/* Allocates the bookkeeping for one async call and its Promise. data (when
+ * given) and jsthis are referenced until async_work_finish(); a string data
+ * is encoded once here into memory the work owns. */
+Async_Work_t *async_work_create(napi_env env, ASYNC_kind kind,
+                                napi_value jsthis, napi_value data,
+                                napi_async_execute_callback execute,
+                                napi_async_complete_callback complete,
+                                napi_value *promise) {
+   Async_Work_t *work;
+   napi_value resource_name;
+   Input_t input;
+
+   work = calloc(1, sizeof(Async_Work_t));
+   if (work == NULL) {
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   napi_create_promise(env, &work->deferred_, promise);
+   if (data != NULL) {
+      if (get_input(env, data, &input) != ADDON_OK) {
+         async_work_reject(env, work);
+         return NULL;
+      }
+      work->len_ = input.len_;
+      if (input.heap_ != NULL) {
+         work->owned_ = input.heap_;
+      } else if (input.data_ == input.stack_) {
+         work->owned_ = malloc(input.len_ + 1);
+         if (work->owned_ == NULL) {
+            napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+            return NULL;
+         }
+         memcpy(work->owned_, input.stack_, input.len_);
+      }
+      if (work->owned_ != NULL) {
+         work->data_ = work->owned_;
+      } else {
+         work->data_ = input.data_;
+         napi_create_reference(env, data, 1, &work->data_ref_);
+      }
+   }
+   if (jsthis != NULL) {
+      napi_create_reference(env, jsthis, 1, &work->this_ref_);
+   }
+   work->kind_ = kind;
+
+   napi_create_string_utf8(env, "xxhash-addon", NAPI_AUTO_LENGTH,
+                           &resource_name);
+   napi_create_async_work(env, NULL, resource_name, execute, complete, work,
+                          &work->work_);
+   return work;
+}
+
+/* Starts work right away, or parks it behind the operation in flight on the
+ * same hasher so that updates are applied in call order. */
+void async_work_queue(napi_env env, Async_Queue_t *queue, Async_Work_t *work) {
+   work->next_ = NULL;
+   if (queue == NULL) {
+      napi_queue_async_work(env, work->work_);
+      return;
+   }
+   if (queue->head_ == NULL) {
+      queue->head_ = work;
+      queue->tail_ = work;
+      napi_queue_async_work(env, work->work_);
+   } else {
+      queue->tail_->next_ = work;
+      queue->tail_ = work;
+   }
+}
+
+/* Settles the Promise, drops the references and starts the next queued
+ * operation. Runs on the main thread from the complete callback. */
+void async_work_finish(napi_env env, Async_Queue_t *queue, Async_Work_t *work,
+                       napi_status status) {
+   napi_value value;
+   napi_value message;
+
+   if (queue != NULL) {
+      queue->head_ = work->next_;
+      if (queue->head_ == NULL) {
+         queue->tail_ = NULL;
+      } else {
+         napi_queue_async_work(env, queue->head_->work_);
+      }
+   }
+
+   if (status == napi_ok && work->error_ != 0) {
+      napi_reject_deferred(env, work->deferred_,
+                           create_file_error(env, work->error_, work->path_));
+   } else if (status == napi_ok) {
+      if (work->digest_size_ > 0) {
+         napi_create_buffer_copy(env, work->digest_size_, work->digest_, NULL,
+                                 &value);
+      } else {
+         napi_get_undefined(env, &value);
+      }
+      napi_resolve_deferred(env, work->deferred_, value);
+   } else {
+      napi_create_string_utf8(env, "Async hashing was cancelled",
+                              NAPI_AUTO_LENGTH, &message);
+      napi_create_error(env, NULL, message, &value);
+      napi_reject_deferred(env, work->deferred_, value);
+   }
+
+   async_work_free(env, work);
+}
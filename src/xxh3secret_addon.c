@@ -0,0 +1,129 @@
+#include "xxhash_addon.h"
+
+/* Secrets are kept on a cache-line boundary. */
+#define SECRET_ALIGN 64
+
+/* Tags objects made by this constructor so that hash() can tell them from
+ * other wrapped objects before unwrapping. */
+static const napi_type_tag secret_type_tag = {0x9e3779b185ebca87ULL,
+                                              0xc2b2ae3d27d4eb4fULL};
+
+XXH3Secret_Wrapper_t *get_xxh3_secret(napi_env env, napi_value value) {
+   bool is_secret = false;
+   XXH3Secret_Wrapper_t *secret = NULL;
+
+   if (napi_check_object_type_tag(env, value, &secret_type_tag,
+                                  &is_secret) != napi_ok ||
+       !is_secret) {
+      return NULL;
+   }
+   napi_unwrap(env, value, (void **)&secret);
+   return secret;
+}
+
+static void destroy(napi_env _unused_env, void *obj, void *_unused_hint) {
+   XXH3Secret_Wrapper_t *secret = (XXH3Secret_Wrapper_t *)obj;
+   (void)_unused_env;
+   (void)_unused_hint;
+   napi_delete_reference(secret->env_, secret->wrapper_);
+   free(secret);
+}
+
+/* new XXH3Secret(seed) derives a secret with XXH3_generateSecret_fromSeed();
+ * hashing with it gives the same results as hashing with the seed, minus the
+ * per-call secret derivation for long inputs. new XXH3Secret(entropy[,
+ * size]) runs XXH3_generateSecret() over any string or binary entropy. */
+static napi_value create_instance(napi_env env, napi_callback_info info) {
+   size_t argc = 2;
+   napi_value args[2];
+   napi_value jsthis;
+   napi_valuetype type = napi_undefined;
+   napi_valuetype size_type = napi_undefined;
+   uint32_t size = XXH3_SECRET_DEFAULT_SIZE;
+   XXH64_hash_t seed = 0;
+   int from_seed = 0;
+   Input_t entropy;
+   XXH3Secret_Wrapper_t *obj;
+
+   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);
+   if (argc > 0) {
+      napi_typeof(env, args[0], &type);
+   }
+   if (type == napi_number || type == napi_bigint) {
+      if (get_seed_value(env, args[0], KEY_SEED64, &seed) != ADDON_OK) {
+         return NULL;
+      }
+      from_seed = 1;
+   } else {
+      if (argc > 1) {
+         napi_typeof(env, args[1], &size_type);
+      }
+      if (size_type != napi_undefined &&
+          (napi_get_value_uint32(env, args[1], &size) != napi_ok ||
+           size < XXH3_SECRET_SIZE_MIN)) {
+         napi_throw_range_error(
+             env, NULL,
+             "Secret size must be >= " QUOTE(XXH3_SECRET_SIZE_MIN));
+         return NULL;
+      }
+      if (get_input(env, args[0], &entropy) != ADDON_OK) {
+         return NULL;
+      }
+   }
+
+   obj = malloc(sizeof(XXH3Secret_Wrapper_t) + size + SECRET_ALIGN - 1);
+   if (obj == NULL) {
+      if (!from_seed) {
+         RELEASE_INPUT(entropy)
+      }
+      napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);
+      return NULL;
+   }
+   obj->env_ = env;
+   obj->seed_ = seed;
+   obj->fromSeed_ = from_seed;
+   obj->secretSize_ = size;
+   obj->secret_ = (unsigned char *)(((uintptr_t)(obj + 1) + SECRET_ALIGN - 1) &
+                                    ~(uintptr_t)(SECRET_ALIGN - 1));
+   if (from_seed) {
+      XXH3_generateSecret_fromSeed(obj->secret_, seed);
+   } else {
+      XXH3_generateSecret(obj->secret_, size, entropy.data_, entropy.len_);
+      RELEASE_INPUT(entropy)
+   }
+
+   napi_type_tag_object(env, jsthis, &secret_type_tag);
+   napi_wrap(env, jsthis, (void *)obj, destroy, NULL, &obj->wrapper_);
+   return jsthis;
+}
+
+static napi_value get_size(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   napi_value result;
+   XXH3Secret_Wrapper_t *secret;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&secret);
+   napi_create_uint32(env, (uint32_t)secret->secretSize_, &result);
+   return result;
+}
+
+/* toBuffer() copies the secret out, e.g. for new XXHash3(secret). */
+static napi_value to_buffer(napi_env env, napi_callback_info info) {
+   napi_value jsthis;
+   napi_value result;
+   XXH3Secret_Wrapper_t *secret;
+
+   napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);
+   napi_unwrap(env, jsthis, (void **)&secret);
+   napi_create_buffer_copy(env, secret->secretSize_, secret->secret_, NULL,
+                           &result);
+   return result;
+}
+
+napi_value init_XXH3Secret(napi_env env, napi_value exports) {
+   napi_property_descriptor properties[] = {
+       {"size", NULL, NULL, get_size, NULL, NULL, napi_default, NULL},
+       {"toBuffer", NULL, to_buffer, NULL, NULL, NULL, napi_default, NULL}};
+   DEFINE_CLASS(XXH3Secret, (Class_data_t *)NULL)
+}
@@ -1,9 +1,25 @@
 #include "xxhash_addon.h"
 
+STATS_CLASS(STATS_XXH128)
 UPDATE(XXHash3_Wrapper_t, XXH3_128bits_update)
 DIGEST(XXHash3_Wrapper_t, XXH3_128bits_digest, XXH128_)
+DIGEST_INTO(XXHash3_Wrapper_t, XXH3_128bits_digest, XXH128_)
+DIGEST_VALUE(XXHash3_Wrapper_t, XXH3_128bits_digest, XXH128_)
 RESET3(XXHash3_Wrapper_t, XXH3_128bits_reset)
-HASH(XXH128_, XXH3_128bits_withSeed)
+ONESHOT3(XXH128_, XXH3_128bits)
+HASH(XXH128_)
+HASH_INTO(XXH128_, XXH3_128bits_withSeed)
+HASH_VALUE(XXH128_)
+HASH_BATCH(XXH128_, XXH3_128bits_withSeed)
+HASH_COLUMNS(XXH128_)
+HASH_FILE(XXH128_, XXH3_state_t, XXH3_createState, XXH3_freeState,
+          XXH3_128bits_reset_withSeed, XXH3_128bits_update,
+          XXH3_128bits_digest)
+HASH_PARALLEL(XXH128_, XXH3_128bits_withSeed)
+ASYNC(XXHash3_Wrapper_t, XXH3_128bits_update, XXH3_128bits_digest, XXH128_,
+      XXH3_128bits_withSeed)
 DESTROY3(XXHash3_Wrapper_t, XXH3_freeState)
+CLONE3(XXHash3_Wrapper_t, XXH3_createState, XXH3_copyState)
+STATE(XXHash3_Wrapper_t, XXH3_createState, 3, STATE_XXH128)
 CREATE3(XXHash3_Wrapper_t, XXH3_createState, XXH3_128bits_reset)
-INIT(XXHash128)
+INIT3(XXHash128)
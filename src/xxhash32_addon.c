@@ -1,9 +1,22 @@
 #include "xxhash_addon.h"
 
+STATS_CLASS(STATS_XXH32)
 UPDATE(XXHash32_Wrapper_t, XXH32_update)
 DIGEST(XXHash32_Wrapper_t, XXH32_digest, XXH32_)
+DIGEST_INTO(XXHash32_Wrapper_t, XXH32_digest, XXH32_)
+DIGEST_VALUE(XXHash32_Wrapper_t, XXH32_digest, XXH32_)
 RESET(XXHash32_Wrapper_t, XXH32_reset)
-HASH(XXH32_, XXH32)
+ONESHOT(XXH32_, XXH32, KEY_SEED32)
+HASH(XXH32_)
+HASH_INTO(XXH32_, XXH32)
+HASH_VALUE(XXH32_)
+HASH_BATCH(XXH32_, XXH32)
+HASH_COLUMNS(XXH32_)
+HASH_FILE(XXH32_, XXH32_state_t, XXH32_createState, XXH32_freeState,
+          XXH32_reset, XXH32_update, XXH32_digest)
+ASYNC(XXHash32_Wrapper_t, XXH32_update, XXH32_digest, XXH32_, XXH32)
 DESTROY(XXHash32_Wrapper_t, XXH32_freeState)
+CLONE(XXHash32_Wrapper_t, XXH32_createState, XXH32_copyState)
+STATE(XXHash32_Wrapper_t, XXH32_createState, 32, STATE_XXH32)
 CREATE32(XXHash32_Wrapper_t, XXH32_createState, XXH32_reset)
 INIT(XXHash32)
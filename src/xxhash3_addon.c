@@ -1,9 +1,24 @@
 #include "xxhash_addon.h"
 
+STATS_CLASS(STATS_XXH3)
 UPDATE(XXHash3_Wrapper_t, XXH3_64bits_update)
 DIGEST(XXHash3_Wrapper_t, XXH3_64bits_digest, XXH64_)
+DIGEST_INTO(XXHash3_Wrapper_t, XXH3_64bits_digest, XXH64_)
+DIGEST_VALUE(XXHash3_Wrapper_t, XXH3_64bits_digest, XXH64_)
 RESET3(XXHash3_Wrapper_t, XXH3_64bits_reset)
-HASH(XXH64_, XXH3_64bits_withSeed)
+ONESHOT3(XXH64_, XXH3_64bits)
+HASH(XXH64_)
+HASH_INTO(XXH64_, XXH3_64bits_withSeed)
+HASH_VALUE(XXH64_)
+HASH_BATCH(XXH64_, XXH3_64bits_withSeed)
+HASH_COLUMNS(XXH64_)
+HASH_FILE(XXH64_, XXH3_state_t, XXH3_createState, XXH3_freeState,
+          XXH3_64bits_reset_withSeed, XXH3_64bits_update, XXH3_64bits_digest)
+HASH_PARALLEL(XXH64_, XXH3_64bits_withSeed)
+ASYNC(XXHash3_Wrapper_t, XXH3_64bits_update, XXH3_64bits_digest, XXH64_,
+      XXH3_64bits_withSeed)
 DESTROY3(XXHash3_Wrapper_t, XXH3_freeState)
+CLONE3(XXHash3_Wrapper_t, XXH3_createState, XXH3_copyState)
+STATE(XXHash3_Wrapper_t, XXH3_createState, 3, STATE_XXH3)
 CREATE3(XXHash3_Wrapper_t, XXH3_createState, XXH3_64bits_reset)
-INIT(XXHash3)
+INIT3(XXHash3)
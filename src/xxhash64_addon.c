@@ -1,9 +1,22 @@
 #include "xxhash_addon.h"
 
+STATS_CLASS(STATS_XXH64)
 UPDATE(XXHash64_Wrapper_t, XXH64_update)
 DIGEST(XXHash64_Wrapper_t, XXH64_digest, XXH64_)
+DIGEST_INTO(XXHash64_Wrapper_t, XXH64_digest, XXH64_)
+DIGEST_VALUE(XXHash64_Wrapper_t, XXH64_digest, XXH64_)
 RESET(XXHash64_Wrapper_t, XXH64_reset)
-HASH(XXH64_, XXH64)
+ONESHOT(XXH64_, XXH64, KEY_SEED64)
+HASH(XXH64_)
+HASH_INTO(XXH64_, XXH64)
+HASH_VALUE(XXH64_)
+HASH_BATCH(XXH64_, XXH64)
+HASH_COLUMNS(XXH64_)
+HASH_FILE(XXH64_, XXH64_state_t, XXH64_createState, XXH64_freeState,
+          XXH64_reset, XXH64_update, XXH64_digest)
+ASYNC(XXHash64_Wrapper_t, XXH64_update, XXH64_digest, XXH64_, XXH64)
 DESTROY(XXHash64_Wrapper_t, XXH64_freeState)
+CLONE(XXHash64_Wrapper_t, XXH64_createState, XXH64_copyState)
+STATE(XXHash64_Wrapper_t, XXH64_createState, 64, STATE_XXH64)
 CREATE64(XXHash64_Wrapper_t, XXH64_createState, XXH64_reset)
 INIT(XXHash64)
@@ -1,30 +1,64 @@
 #ifndef XXHASH_ADDON_H_
 #define XXHASH_ADDON_H_
 
+/* The addon is C99 (see binding.gyp). uv.h and posix_fadvise() need POSIX
+ * declarations that glibc hides under -std=c99, so this must come before
+ * any system header, hence first in this header. */
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 
-/* DON'T REMOVE: I use clang to verify this file is C89-compliant. */
-#if 0
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wc99-extensions"
-#pragma clang diagnostic ignored "-Wcomment"
-#endif
-#endif
-
 #include <node_api.h>
 
-/* DON'T REMOVE: I use clang to verify this file is C89-compliant. */
-#if 0
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#endif
-#endif
-
+/* For XXH3_generateSecret() and the _withSecretandSeed variants. */
+#define XXH_STATIC_LINKING_ONLY
 #include "xxhash.h"
-#ifdef XXHASH_DISPATCH
-#include "xxh_x86dispatch.h"
+
+/* The XXH3 and XXH128 functions that can run the long-input loop go through
+ * the SIMD backend selected at run time, see simd.c. */
+XXH64_hash_t simd_XXH3_64bits(const void *input, size_t len);
+XXH64_hash_t simd_XXH3_64bits_withSeed(const void *input, size_t len,
+                                       XXH64_hash_t seed);
+XXH64_hash_t simd_XXH3_64bits_withSecret(const void *input, size_t len,
+                                         const void *secret,
+                                         size_t secret_size);
+XXH64_hash_t simd_XXH3_64bits_withSecretandSeed(const void *input,
+                                                size_t len,
+                                                const void *secret,
+                                                size_t secret_size,
+                                                XXH64_hash_t seed);
+XXH128_hash_t simd_XXH3_128bits(const void *input, size_t len);
+XXH128_hash_t simd_XXH3_128bits_withSeed(const void *input, size_t len,
+                                         XXH64_hash_t seed);
+XXH128_hash_t simd_XXH3_128bits_withSecret(const void *input, size_t len,
+                                           const void *secret,
+                                           size_t secret_size);
+XXH128_hash_t simd_XXH3_128bits_withSecretandSeed(const void *input,
+                                                  size_t len,
+                                                  const void *secret,
+                                                  size_t secret_size,
+                                                  XXH64_hash_t seed);
+XXH128_hash_t simd_XXH128(const void *input, size_t len, XXH64_hash_t seed);
+XXH_errorcode simd_XXH3_64bits_update(XXH3_state_t *state, const void *input,
+                                      size_t len);
+XXH_errorcode simd_XXH3_128bits_update(XXH3_state_t *state,
+                                       const void *input, size_t len);
+
+#ifndef SIMD_NO_REDIRECT
+#define XXH3_64bits simd_XXH3_64bits
+#define XXH3_64bits_withSeed simd_XXH3_64bits_withSeed
+#define XXH3_64bits_withSecret simd_XXH3_64bits_withSecret
+#define XXH3_64bits_withSecretandSeed simd_XXH3_64bits_withSecretandSeed
+#define XXH3_128bits simd_XXH3_128bits
+#define XXH3_128bits_withSeed simd_XXH3_128bits_withSeed
+#define XXH3_128bits_withSecret simd_XXH3_128bits_withSecret
+#define XXH3_128bits_withSecretandSeed simd_XXH3_128bits_withSecretandSeed
+#define XXH128 simd_XXH128
+#define XXH3_64bits_update simd_XXH3_64bits_update
+#define XXH3_128bits_update simd_XXH3_128bits_update
 #endif
 
 #define STRINGIZE(x) #x
@@ -52,23 +86,295 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
 #define type_check_data_buffer(ENV, ARGS, ARGC) ADDON_OK
 #endif /* ENABLE_RUNTIME_TYPE_CHECK */
 
+/* Strings shorter than this many UTF-16 units always fit INPUT_STACK_SIZE
+ * bytes of UTF-8 (3 bytes per unit at most, plus the terminator). */
+#define INPUT_STACK_SIZE 512
+
+/* A data argument: a Buffer or any other ArrayBufferView, an ArrayBuffer or
+ * a string, hashed as its UTF-8 encoding. Only strings are copied, to
+ * stack_ when short and to heap_ otherwise; see get_input(). */
+typedef struct {
+   void *data_;
+   size_t len_;
+   char *heap_;
+   char stack_[INPUT_STACK_SIZE];
+} Input_t;
+
+#define RELEASE_INPUT(INPUT)                                                  \
+   if ((INPUT).heap_ != NULL) {                                               \
+      free((INPUT).heap_);                                                    \
+   }
+
+/* What the seedOrSecret argument of hash() may hold: a 32-bit seed (XXH32),
+ * a 64-bit seed (XXH64), or a seed or secret (XXH3 and XXH128). */
+typedef enum { KEY_SEED32 = 0, KEY_SEED64, KEY_SEED_OR_SECRET } KEY_kind;
+
+/* A resolved seedOrSecret. secret_ is NULL for a plain seed. fromSeed_ marks
+ * a secret generated from seed_, which is hashed with the _withSecretandSeed
+ * variants so that results match those of the seed itself. */
+typedef struct {
+   XXH64_hash_t seed_;
+   const void *secret_;
+   size_t secretSize_;
+   int fromSeed_;
+} Hash_key_t;
+
+typedef enum {
+   ASYNC_HASH = 0,
+   ASYNC_UPDATE,
+   ASYNC_DIGEST,
+   ASYNC_HASH_FILE
+} ASYNC_kind;
+
+/* One hashAsync()/updateAsync()/digestAsync() call. The input buffer and the
+ * hasher are referenced until the work completes so neither can be collected
+ * while the threadpool reads them. A string input has no backing store to
+ * reference; its UTF-8 copy is owned_ by the work instead. */
+typedef struct Async_Work_s {
+   napi_async_work work_;
+   napi_deferred deferred_;
+   napi_ref data_ref_;
+   napi_ref this_ref_;
+   ASYNC_kind kind_;
+   void *hasher_;
+   void *data_;
+   size_t len_;
+   char *owned_;
+   char *path_;
+   uint64_t offset_;
+   uint64_t length_;
+   int error_;
+   unsigned char digest_[sizeof(XXH128_canonical_t)];
+   size_t digest_size_;
+   struct Async_Work_s *next_;
+} Async_Work_t;
+
+/* Per-hasher FIFO of async work. head_ is the operation in flight; async
+ * calls queue behind it while sync calls on a busy hasher throw. */
+typedef struct {
+   Async_Work_t *head_;
+   Async_Work_t *tail_;
+} Async_Queue_t;
+
+/* Per-env, per-class data for clone() and importState(): the constructor,
+ * and a ready-made object that the constructor wraps as is, instead of
+ * reading its arguments, while new_adopted_instance() runs it. */
+typedef struct {
+   napi_env env_;
+   napi_ref cons_;
+   void *adopted_;
+} Class_data_t;
+
+/* Helpers shared by the per-class macros below; defined in util.c. */
+ADDON_errorcode get_byte_range(napi_env env, napi_value value, void **data,
+                               size_t *len);
+ADDON_errorcode get_input(napi_env env, napi_value value, Input_t *input);
+Class_data_t *create_class_data(napi_env env);
+napi_value new_adopted_instance(napi_env env, Class_data_t *class_data,
+                                void *obj, napi_finalize destroy);
+ADDON_errorcode get_seed_value(napi_env env, napi_value value, KEY_kind kind,
+                               XXH64_hash_t *seed);
+ADDON_errorcode get_hash_key(napi_env env, napi_value value, KEY_kind kind,
+                             Hash_key_t *key);
+Async_Work_t *async_work_create(napi_env env, ASYNC_kind kind,
+                                napi_value jsthis, napi_value data,
+                                napi_async_execute_callback execute,
+                                napi_async_complete_callback complete,
+                                napi_value *promise);
+void async_work_reject(napi_env env, Async_Work_t *work);
+void async_work_queue(napi_env env, Async_Queue_t *queue, Async_Work_t *work);
+void async_work_finish(napi_env env, Async_Queue_t *queue, Async_Work_t *work,
+                       napi_status status);
+
+/* Native file reading for hashFile(); defined in file.c. Errors are libuv
+ * error codes (negative), 0 on success. */
+typedef void (*File_consumer)(void *ctx, const void *data, size_t len);
+int read_file_range(const char *path, uint64_t offset, uint64_t length,
+                    File_consumer consume, void *ctx);
+ADDON_errorcode get_file_args(napi_env env, napi_callback_info info,
+                              char **path, uint64_t *offset,
+                              uint64_t *length);
+napi_value create_file_error(napi_env env, int err, const char *path);
+
+/* Free lists of hasher wrappers, each with its xxHash state still attached,
+ * one per wrapper type; defined in pool.c. */
+#define POOL_MAX 64
+typedef struct {
+   void *items_[POOL_MAX];
+   size_t count_;
+} Pool_t;
+extern Pool_t pool_XXHash3_Wrapper_t;
+extern Pool_t pool_XXHash64_Wrapper_t;
+extern Pool_t pool_XXHash32_Wrapper_t;
+void *pool_get(Pool_t *pool);
+int pool_put(Pool_t *pool, void *wrapper);
+
+/* Tree hashing for hashParallel(); defined in parallel.c. */
+#define PARALLEL_DEFAULT_CHUNK_SIZE (1 << 20)
+#define PARALLEL_MIN_CHUNK_SIZE 1024
+typedef void (*Leaf_hasher)(const void *data, size_t len, unsigned char *out);
+unsigned int parallel_default_threads(void);
+size_t parallel_chunk_count(size_t len, size_t chunk_size);
+void hash_parallel_leaves(const unsigned char *data, size_t len,
+                          size_t chunk_size, unsigned int threads,
+                          Leaf_hasher leaf, size_t leaf_size,
+                          unsigned char *leaves);
+ADDON_errorcode get_parallel_options(napi_env env, napi_value value,
+                                     size_t *chunk_size,
+                                     unsigned int *threads);
+void *get_into_target(napi_env env, napi_value out, napi_value offset,
+                      size_t digest_size, napi_value *end);
+ADDON_errorcode get_batch_offsets(napi_env env, napi_value value,
+                                  size_t data_len, const uint32_t **offsets,
+                                  uint32_t *count);
+ADDON_errorcode get_batch_output(napi_env env, napi_value value,
+                                 uint32_t count, size_t digest_size,
+                                 napi_typedarray_type lane_type,
+                                 unsigned char **out, int *canonical,
+                                 napi_value *result);
+ADDON_errorcode get_key_hashes(napi_env env, napi_value keys,
+                               napi_value layout, XXH64_hash_t seed,
+                               XXH64_hash_t **hashes, uint32_t *count);
+
+/* addMany()/hasMany() hash all their keys first, then walk the table with
+ * the cache line of the key MEMBERSHIP_PREFETCH places ahead requested. */
+#define CACHE_LINE_SIZE 64
+#define MEMBERSHIP_PREFETCH 8
+void *calloc_lines(size_t size, void **base);
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#else
+#define PREFETCH(ADDR) ((void)(ADDR))
+#endif
+
+/* Columnar keys for hashColumns(); defined in columns.c, which documents
+ * how a row's key is formed. offsets_ is NULL for a fixed-width column of
+ * width_-byte elements. */
+#define COLUMN_BLOCK_ROWS 256
+typedef struct {
+   const unsigned char *data_;
+   const uint32_t *offsets_;
+   size_t width_;
+} Column_t;
+
+typedef struct {
+   Column_t *columns_;
+   uint32_t count_;
+   uint32_t rows_;
+   uint32_t variable_;
+   size_t row_width_;
+   int swap_;
+   int in_place_;
+   unsigned char *scratch_;
+   size_t scratch_size_;
+} Column_set_t;
+
+#define RELEASE_COLUMNS(SET)                                                  \
+   free((SET).columns_);                                                      \
+   free((SET).scratch_);
+
+ADDON_errorcode get_columns(napi_env env, napi_value columns,
+                            napi_value rows, Column_set_t *set);
+const unsigned char *column_keys(Column_set_t *set, uint32_t first,
+                                 uint32_t rows, size_t *ends);
+
+/* Layout of native (non-canonical) hash values written into a typed array:
+ * XXH32 takes one uint32 lane, XXH64/XXH3 one uint64 lane and XXH128 two
+ * uint64 lanes, high64 first to match the canonical byte order. */
+#define LANE_TYPE_XXH32_ napi_uint32_array
+#define LANE_TYPE_XXH64_ napi_biguint64_array
+#define LANE_TYPE_XXH128_ napi_biguint64_array
+
+/* digestNumber()/hashNumber() for XXH32, digestBigInt()/hashBigInt() for
+ * the 64- and 128-bit hashes: the native value without a result Buffer. */
+#define VALUE_SUFFIX_XXH32_ "Number"
+#define VALUE_SUFFIX_XXH64_ "BigInt"
+#define VALUE_SUFFIX_XXH128_ "BigInt"
+
+#define CREATE_VALUE_XXH32_(SUM) napi_create_uint32(env, (SUM), &result);
+#define CREATE_VALUE_XXH64_(SUM)                                              \
+   napi_create_bigint_uint64(env, (SUM), &result);
+#define CREATE_VALUE_XXH128_(SUM)                                             \
+   {                                                                          \
+      uint64_t words[2];                                                      \
+      words[0] = (SUM).low64;                                                 \
+      words[1] = (SUM).high64;                                                \
+      napi_create_bigint_words(env, 0, 2, words, &result);                    \
+   }
+
+#define STORE_LANES_XXH32_(OUT, SUM) ((XXH32_hash_t *)(OUT))[0] = (SUM);
+#define STORE_LANES_XXH64_(OUT, SUM) ((XXH64_hash_t *)(OUT))[0] = (SUM);
+#define STORE_LANES_XXH128_(OUT, SUM)                                         \
+   ((XXH64_hash_t *)(OUT))[0] = (SUM).high64;                                 \
+   ((XXH64_hash_t *)(OUT))[1] = (SUM).low64;
+
+/* Opt-in call statistics, see stats.c. STATS_CLASS names the class that a
+ * translation unit defines; the UPDATE, DIGEST and HASH families bracket
+ * their work with STATS_BEGIN and STATS_END, which cost one test of
+ * stats_enabled each while statistics are off. */
+typedef enum {
+   STATS_XXH32 = 0,
+   STATS_XXH64,
+   STATS_XXH3,
+   STATS_XXH128,
+   STATS_CLASS_COUNT
+} STATS_class;
+
+typedef enum {
+   STATS_HASH = 0,
+   STATS_UPDATE,
+   STATS_DIGEST,
+   STATS_OP_COUNT
+} STATS_op;
+
+extern int stats_enabled;
+uint64_t stats_begin(STATS_class cls, STATS_op op);
+void stats_end(STATS_class cls, STATS_op op, size_t len, uint64_t start);
+
+#define STATS_CLASS(CLASS) static const STATS_class stats_class = CLASS;
+
+/* stats_enabled is switched by enableStats() on one thread while hashers
+ * on others test it, so it is read as a relaxed atomic. */
+#if defined(_MSC_VER)
+#define STATS_ENABLED() (*(volatile int *)&stats_enabled)
+#else
+#define STATS_ENABLED() __atomic_load_n(&stats_enabled, __ATOMIC_RELAXED)
+#endif
+
+#define STATS_BEGIN(OP)                                                       \
+   stats_start = STATS_ENABLED() ? stats_begin(stats_class, (OP)) : 0;
+
+#define STATS_END(OP, LEN)                                                    \
+   if (STATS_ENABLED()) {                                                     \
+      stats_end(stats_class, (OP), (LEN), stats_start);                       \
+   }
+
+#define THROW_IF_BUSY(HASHER)                                                 \
+   if ((HASHER)->queue_.head_ != NULL) {                                      \
+      napi_throw_error(env, NULL, "Hasher has an async operation in flight"); \
+      return NULL;                                                            \
+   }
+
 #define UPDATE(WRAPPER_TYPE, INTERNAL_UPDATE)                                 \
    static napi_value update(napi_env env, napi_callback_info info) {          \
       size_t argc = 1;                                                        \
       napi_value args[1];                                                     \
       napi_value jsthis;                                                      \
-      void *data;                                                             \
-      size_t buf_len;                                                         \
+      Input_t input;                                                          \
       WRAPPER_TYPE *hasher;                                                   \
+      uint64_t stats_start;                                                   \
                                                                               \
       napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);                \
-      if (type_check_data_buffer(env, args, argc) != ADDON_OK) {              \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
+      if (get_input(env, args[0], &input) != ADDON_OK) {                      \
          return NULL;                                                         \
       }                                                                       \
-      napi_get_buffer_info(env, args[0], &data, &buf_len);                    \
-      napi_unwrap(env, jsthis, (void **)&hasher);                             \
                                                                               \
-      INTERNAL_UPDATE(hasher->state_, data, buf_len);                         \
+      STATS_BEGIN(STATS_UPDATE)                                               \
+      INTERNAL_UPDATE(hasher->state_, input.data_, input.len_);               \
+      STATS_END(STATS_UPDATE, input.len_)                                     \
+      RELEASE_INPUT(input)                                                    \
       return NULL;                                                            \
    }
 
@@ -87,33 +393,562 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
       TYPE_PREFIX##hash_t sum;                                                \
       TYPE_PREFIX##canonical_t canonical_sum;                                 \
       TYPE_PREFIX##canonical_t *result_data;                                  \
+      uint64_t stats_start;                                                   \
                                                                               \
       napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
       napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
                                                                               \
+      STATS_BEGIN(STATS_DIGEST)                                               \
       sum = INTERNAL_DIGEST(hasher->state_);                                  \
       CANONICALIZE(TYPE_PREFIX)                                               \
+      STATS_END(STATS_DIGEST, 0)                                              \
                                                                               \
       return result;                                                          \
    }
 
-#define HASH(TYPE_PREFIX, HASH_FUNC)                                          \
+/* oneshot() hashes under a Hash_key_t for hash(data[, seedOrSecret]) and
+ * hashNumber()/hashBigInt(). ONESHOT is for the seed-only XXH32/XXH64;
+ * ONESHOT3 takes the XXH3 function name without its _with* suffix. */
+#define ONESHOT(TYPE_PREFIX, HASH_FUNC, KEY_KIND)                             \
+   static const KEY_kind oneshot_key_kind = KEY_KIND;                         \
+                                                                              \
+   static TYPE_PREFIX##hash_t oneshot(const void *data, size_t len,           \
+                                      const Hash_key_t *key) {                \
+      return HASH_FUNC(data, len, (TYPE_PREFIX##hash_t)key->seed_);           \
+   }
+
+#define ONESHOT3(TYPE_PREFIX, HASH_FUNC)                                      \
+   static const KEY_kind oneshot_key_kind = KEY_SEED_OR_SECRET;               \
+                                                                              \
+   static TYPE_PREFIX##hash_t oneshot(const void *data, size_t len,           \
+                                      const Hash_key_t *key) {                \
+      if (key->secret_ == NULL) {                                             \
+         return HASH_FUNC##_withSeed(data, len, key->seed_);                  \
+      }                                                                       \
+      if (key->fromSeed_) {                                                   \
+         return HASH_FUNC##_withSecretandSeed(data, len, key->secret_,        \
+                                              key->secretSize_, key->seed_);  \
+      }                                                                       \
+      return HASH_FUNC##_withSecret(data, len, key->secret_,                  \
+                                    key->secretSize_);                        \
+   }
+
+#define HASH(TYPE_PREFIX)                                                     \
    static napi_value hash(napi_env env, napi_callback_info info) {            \
+      size_t argc = 2;                                                        \
+      napi_value args[2];                                                     \
+      napi_value result;                                                      \
+      Input_t input;                                                          \
+      Hash_key_t key;                                                         \
+      TYPE_PREFIX##hash_t sum;                                                \
+      TYPE_PREFIX##canonical_t canonical_sum;                                 \
+      TYPE_PREFIX##canonical_t *result_data;                                  \
+      uint64_t stats_start;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      if (get_hash_key(env, argc > 1 ? args[1] : NULL, oneshot_key_kind,      \
+                       &key) != ADDON_OK ||                                   \
+          get_input(env, args[0], &input) != ADDON_OK) {                      \
+         return NULL;                                                         \
+      }                                                                       \
+      STATS_BEGIN(STATS_HASH)                                                 \
+      sum = oneshot(input.data_, input.len_, &key);                           \
+      RELEASE_INPUT(input)                                                    \
+                                                                              \
+      CANONICALIZE(TYPE_PREFIX)                                               \
+      STATS_END(STATS_HASH, input.len_)                                       \
+      return result;                                                          \
+   }
+
+/* digestInto(out[, offset]) writes the canonical digest into out and returns
+ * the offset just past it. */
+#define DIGEST_INTO(WRAPPER_TYPE, INTERNAL_DIGEST, TYPE_PREFIX)               \
+   static napi_value digest_into(napi_env env, napi_callback_info info) {     \
+      size_t argc = 2;                                                        \
+      napi_value args[2];                                                     \
+      napi_value jsthis;                                                      \
+      napi_value result;                                                      \
+      WRAPPER_TYPE *hasher;                                                   \
+      TYPE_PREFIX##canonical_t *target;                                       \
+      uint64_t stats_start;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);                \
+      if (argc < 1) {                                                         \
+         napi_throw_range_error(env, NULL, "One param is expected");          \
+         return NULL;                                                         \
+      }                                                                       \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
+      target = get_into_target(env, args[0], argc > 1 ? args[1] : NULL,       \
+                               sizeof(TYPE_PREFIX##canonical_t), &result);    \
+      if (target == NULL) {                                                   \
+         return NULL;                                                         \
+      }                                                                       \
+                                                                              \
+      STATS_BEGIN(STATS_DIGEST)                                               \
+      TYPE_PREFIX##canonicalFromHash(target, INTERNAL_DIGEST(hasher->state_));\
+      STATS_END(STATS_DIGEST, 0)                                              \
+      return result;                                                          \
+   }
+
+#define DIGEST_VALUE(WRAPPER_TYPE, INTERNAL_DIGEST, TYPE_PREFIX)              \
+   static const char digest_value_name[] =                                    \
+       "digest" VALUE_SUFFIX_##TYPE_PREFIX;                                   \
+                                                                              \
+   static napi_value digest_value(napi_env env, napi_callback_info info) {    \
+      napi_value jsthis;                                                      \
+      napi_value result;                                                      \
+      WRAPPER_TYPE *hasher;                                                   \
+      TYPE_PREFIX##hash_t sum;                                                \
+      uint64_t stats_start;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
+                                                                              \
+      STATS_BEGIN(STATS_DIGEST)                                               \
+      sum = INTERNAL_DIGEST(hasher->state_);                                  \
+      CREATE_VALUE_##TYPE_PREFIX(sum)                                         \
+      STATS_END(STATS_DIGEST, 0)                                              \
+      return result;                                                          \
+   }
+
+/* hashInto(data, out[, offset]) is hash() writing into out; it returns the
+ * offset just past the digest. */
+#define HASH_INTO(TYPE_PREFIX, HASH_FUNC)                                     \
+   static napi_value hash_into(napi_env env, napi_callback_info info) {       \
+      size_t argc = 3;                                                        \
+      napi_value args[3];                                                     \
+      napi_value result;                                                      \
+      Input_t input;                                                          \
+      TYPE_PREFIX##canonical_t *target;                                       \
+      uint64_t stats_start;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      if (argc < 2) {                                                         \
+         napi_throw_range_error(env, NULL, "Two params are expected");        \
+         return NULL;                                                         \
+      }                                                                       \
+      target = get_into_target(env, args[1], argc > 2 ? args[2] : NULL,       \
+                               sizeof(TYPE_PREFIX##canonical_t), &result);    \
+      if (target == NULL) {                                                   \
+         return NULL;                                                         \
+      }                                                                       \
+      if (get_input(env, args[0], &input) != ADDON_OK) {                      \
+         return NULL;                                                         \
+      }                                                                       \
+                                                                              \
+      STATS_BEGIN(STATS_HASH)                                                 \
+      TYPE_PREFIX##canonicalFromHash(target,                                  \
+                                     HASH_FUNC(input.data_, input.len_, 0));  \
+      STATS_END(STATS_HASH, input.len_)                                       \
+      RELEASE_INPUT(input)                                                    \
+      return result;                                                          \
+   }
+
+#define HASH_VALUE(TYPE_PREFIX)                                               \
+   static const char hash_value_name[] = "hash" VALUE_SUFFIX_##TYPE_PREFIX;   \
+                                                                              \
+   static napi_value hash_value(napi_env env, napi_callback_info info) {      \
+      size_t argc = 2;                                                        \
+      napi_value args[2];                                                     \
+      napi_value result;                                                      \
+      Input_t input;                                                          \
+      Hash_key_t key;                                                         \
+      TYPE_PREFIX##hash_t sum;                                                \
+      uint64_t stats_start;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      if (get_hash_key(env, argc > 1 ? args[1] : NULL, oneshot_key_kind,      \
+                       &key) != ADDON_OK ||                                   \
+          get_input(env, args[0], &input) != ADDON_OK) {                      \
+         return NULL;                                                         \
+      }                                                                       \
+      STATS_BEGIN(STATS_HASH)                                                 \
+      sum = oneshot(input.data_, input.len_, &key);                           \
+      RELEASE_INPUT(input)                                                    \
+                                                                              \
+      CREATE_VALUE_##TYPE_PREFIX(sum)                                         \
+      STATS_END(STATS_HASH, input.len_)                                       \
+      return result;                                                          \
+   }
+
+/* hashBatch(buffers[, out]) or hashBatch(data, offsets[, out]).
+ * In the second form, record i spans data[offsets[i], offsets[i + 1]).
+ * Reading the array may run getters that detach or transfer out's buffer,
+ * so array records are hashed into sums first and out is resolved after. */
+#define HASH_BATCH(TYPE_PREFIX, HASH_FUNC)                                    \
+   static napi_value hash_batch(napi_env env, napi_callback_info info) {      \
+      size_t argc = 3;                                                        \
+      napi_value args[3];                                                     \
+      napi_value result;                                                      \
+      napi_value elem;                                                        \
+      size_t out_idx;                                                         \
+      bool is_array = false;                                                  \
+      uint32_t count = 0;                                                     \
+      uint32_t i;                                                             \
+      const uint32_t *offsets = NULL;                                         \
+      Input_t base;                                                           \
+      Input_t input;                                                          \
+      unsigned char *out;                                                     \
+      int canonical;                                                          \
+      TYPE_PREFIX##hash_t sum;                                                \
+      TYPE_PREFIX##hash_t *sums = NULL;                                       \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      if (argc < 1) {                                                         \
+         napi_throw_range_error(env, NULL, "One param is expected");          \
+         return NULL;                                                         \
+      }                                                                       \
+      base.heap_ = NULL;                                                      \
+      napi_is_array(env, args[0], &is_array);                                 \
+      if (is_array) {                                                         \
+         napi_get_array_length(env, args[0], &count);                         \
+         sums = malloc(count > 0 ? count * sizeof(*sums) : 1);                \
+         if (sums == NULL) {                                                  \
+            napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);        \
+            return NULL;                                                      \
+         }                                                                    \
+         for (i = 0; i < count; i++) {                                        \
+            napi_get_element(env, args[0], i, &elem);                         \
+            if (get_input(env, elem, &input) != ADDON_OK) {                   \
+               free(sums);                                                    \
+               return NULL;                                                   \
+            }                                                                 \
+            sums[i] = HASH_FUNC(input.data_, input.len_, 0);                  \
+            RELEASE_INPUT(input)                                              \
+         }                                                                    \
+      } else {                                                                \
+         if (argc < 2) {                                                      \
+            napi_throw_type_error(env, NULL,                                  \
+                                  "Expected an array of buffers or a buffer " \
+                                  "with offsets");                            \
+            return NULL;                                                      \
+         }                                                                    \
+         if (get_input(env, args[0], &base) != ADDON_OK) {                    \
+            return NULL;                                                      \
+         }                                                                    \
+         if (get_batch_offsets(env, args[1], base.len_, &offsets, &count) !=  \
+             ADDON_OK) {                                                      \
+            RELEASE_INPUT(base)                                               \
+            return NULL;                                                      \
+         }                                                                    \
+      }                                                                       \
+      out_idx = is_array ? 1 : 2;                                             \
+      if (get_batch_output(env, argc > out_idx ? args[out_idx] : NULL, count, \
+                           sizeof(TYPE_PREFIX##canonical_t),                  \
+                           LANE_TYPE_##TYPE_PREFIX, &out, &canonical,         \
+                           &result) != ADDON_OK) {                            \
+         free(sums);                                                          \
+         RELEASE_INPUT(base)                                                  \
+         return NULL;                                                         \
+      }                                                                       \
+                                                                              \
+      for (i = 0; i < count; i++) {                                           \
+         if (is_array) {                                                      \
+            sum = sums[i];                                                    \
+         } else {                                                             \
+            sum = HASH_FUNC((unsigned char *)base.data_ + offsets[i],         \
+                            offsets[i + 1] - offsets[i], 0);                  \
+         }                                                                    \
+         if (canonical) {                                                     \
+            TYPE_PREFIX##canonicalFromHash((TYPE_PREFIX##canonical_t *)out,   \
+                                           sum);                              \
+         } else {                                                             \
+            STORE_LANES_##TYPE_PREFIX(out, sum)                               \
+         }                                                                    \
+         out += sizeof(TYPE_PREFIX##canonical_t);                             \
+      }                                                                       \
+      free(sums);                                                             \
+      RELEASE_INPUT(base)                                                     \
+      return result;                                                          \
+   }
+
+/* hashColumns(columns, rowCount[, seedOrSecret[, out]]) hashes every row's
+ * key (see columns.c) with oneshot(), a block of rows at a time. Results go
+ * into a new typed array of native values unless out says otherwise, with
+ * the same out rules as hashBatch(). */
+#define HASH_COLUMNS(TYPE_PREFIX)                                             \
+   static napi_value hash_columns(napi_env env, napi_callback_info info) {    \
+      size_t argc = 4;                                                        \
+      napi_value args[4];                                                     \
+      napi_value result;                                                      \
+      napi_value buffer;                                                      \
+      napi_valuetype out_type = napi_undefined;                               \
+      Column_set_t set;                                                       \
+      Hash_key_t key;                                                         \
+      size_t ends[COLUMN_BLOCK_ROWS];                                         \
+      size_t start;                                                           \
+      const unsigned char *keys;                                              \
+      unsigned char *out;                                                     \
+      int canonical = 0;                                                      \
+      uint32_t first;                                                         \
+      uint32_t rows;                                                          \
+      uint32_t i;                                                             \
+      TYPE_PREFIX##hash_t sum;                                                \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      if (argc < 2) {                                                         \
+         napi_throw_range_error(env, NULL, "Two params are expected");        \
+         return NULL;                                                         \
+      }                                                                       \
+      if (get_hash_key(env, argc > 2 ? args[2] : NULL, oneshot_key_kind,      \
+                       &key) != ADDON_OK ||                                   \
+          get_columns(env, args[0], args[1], &set) != ADDON_OK) {             \
+         return NULL;                                                         \
+      }                                                                       \
+      if (argc > 3) {                                                         \
+         napi_typeof(env, args[3], &out_type);                                \
+      }                                                                       \
+      if (out_type == napi_undefined) {                                       \
+         napi_create_arraybuffer(env,                                         \
+                                 (size_t)set.rows_ *                          \
+                                     sizeof(TYPE_PREFIX##canonical_t),        \
+                                 (void **)&out, &buffer);                     \
+         napi_create_typedarray(                                              \
+             env, LANE_TYPE_##TYPE_PREFIX,                                    \
+             (size_t)set.rows_ * sizeof(TYPE_PREFIX##canonical_t) /           \
+                 (LANE_TYPE_##TYPE_PREFIX == napi_uint32_array ? 4 : 8),      \
+             buffer, 0, &result);                                             \
+      } else if (get_batch_output(env, args[3], set.rows_,                    \
+                                  sizeof(TYPE_PREFIX##canonical_t),           \
+                                  LANE_TYPE_##TYPE_PREFIX, &out, &canonical,  \
+                                  &result) != ADDON_OK) {                     \
+         RELEASE_COLUMNS(set)                                                 \
+         return NULL;                                                         \
+      }                                                                       \
+                                                                              \
+      for (first = 0; first < set.rows_; first += rows) {                     \
+         rows = set.rows_ - first < COLUMN_BLOCK_ROWS ? set.rows_ - first     \
+                                                      : COLUMN_BLOCK_ROWS;    \
+         keys = column_keys(&set, first, rows, ends);                         \
+         if (keys == NULL) {                                                  \
+            RELEASE_COLUMNS(set)                                              \
+            napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);        \
+            return NULL;                                                      \
+         }                                                                    \
+         for (i = 0, start = 0; i < rows; start = ends[i++]) {                \
+            sum = oneshot(keys + start, ends[i] - start, &key);               \
+            if (canonical) {                                                  \
+               TYPE_PREFIX##canonicalFromHash(                                \
+                   (TYPE_PREFIX##canonical_t *)out, sum);                     \
+            } else {                                                          \
+               STORE_LANES_##TYPE_PREFIX(out, sum)                            \
+            }                                                                 \
+            out += sizeof(TYPE_PREFIX##canonical_t);                          \
+         }                                                                    \
+      }                                                                       \
+      RELEASE_COLUMNS(set)                                                    \
+      return result;                                                          \
+   }
+
+/* hashFile(path[, offset[, length]]) hashes a file range with seed 0, read
+ * natively by read_file_range(). file_digest() is shared with the async
+ * variant. */
+#define HASH_FILE(TYPE_PREFIX, STATE_TYPE, INTERNAL_CREATESTATE,              \
+                  INTERNAL_FREESTATE, INTERNAL_RESET, INTERNAL_UPDATE,        \
+                  INTERNAL_DIGEST)                                            \
+   static void file_consume(void *ctx, const void *data, size_t len) {        \
+      INTERNAL_UPDATE((STATE_TYPE *)ctx, data, len);                          \
+   }                                                                          \
+                                                                              \
+   static int file_digest(const char *path, uint64_t offset,                  \
+                          uint64_t length, unsigned char *out) {              \
+      STATE_TYPE *state = INTERNAL_CREATESTATE();                             \
+      int err;                                                                \
+                                                                              \
+      if (state == NULL) {                                                    \
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);           \
+         return -1;                                                           \
+      }                                                                       \
+      INTERNAL_RESET(state, 0);                                               \
+      err = read_file_range(path, offset, length, file_consume, state);       \
+      if (err == 0) {                                                         \
+         TYPE_PREFIX##canonicalFromHash((TYPE_PREFIX##canonical_t *)out,      \
+                                        INTERNAL_DIGEST(state));              \
+      }                                                                       \
+      INTERNAL_FREESTATE(state);                                              \
+      return err;                                                             \
+   }                                                                          \
+                                                                              \
+   static napi_value hash_file(napi_env env, napi_callback_info info) {       \
+      napi_value result;                                                      \
+      void *result_data;                                                      \
+      char *path;                                                             \
+      uint64_t offset;                                                        \
+      uint64_t length;                                                        \
+      int err;                                                                \
+                                                                              \
+      if (get_file_args(env, info, &path, &offset, &length) != ADDON_OK) {    \
+         return NULL;                                                         \
+      }                                                                       \
+      napi_create_buffer(env, sizeof(TYPE_PREFIX##canonical_t), &result_data, \
+                         &result);                                            \
+      err = file_digest(path, offset, length, (unsigned char *)result_data);  \
+      if (err != 0) {                                                         \
+         napi_throw(env, create_file_error(env, err, path));                  \
+         result = NULL;                                                       \
+      }                                                                       \
+      free(path);                                                             \
+      return result;                                                          \
+   }
+
+/* hashAsync(data), updateAsync(data), digestAsync() and hashFileAsync(path)
+ * run the same kernels as their sync counterparts on the libuv threadpool
+ * and return Promises. Must follow HASH_FILE, whose file_digest() it uses. */
+#define ASYNC(WRAPPER_TYPE, INTERNAL_UPDATE, INTERNAL_DIGEST, TYPE_PREFIX,    \
+              HASH_FUNC)                                                      \
+   static void async_execute(napi_env _unused_env, void *data) {              \
+      Async_Work_t *work = (Async_Work_t *)data;                              \
+      WRAPPER_TYPE *hasher = (WRAPPER_TYPE *)work->hasher_;                   \
+      TYPE_PREFIX##hash_t sum;                                                \
+      (void)_unused_env;                                                      \
+                                                                              \
+      if (work->kind_ == ASYNC_UPDATE) {                                      \
+         INTERNAL_UPDATE(hasher->state_, work->data_, work->len_);            \
+         return;                                                              \
+      }                                                                       \
+      if (work->kind_ == ASYNC_HASH_FILE) {                                   \
+         work->error_ = file_digest(work->path_, work->offset_,               \
+                                    work->length_, work->digest_);            \
+         work->digest_size_ = sizeof(TYPE_PREFIX##canonical_t);               \
+         return;                                                              \
+      }                                                                       \
+      sum = work->kind_ == ASYNC_HASH                                         \
+                ? HASH_FUNC(work->data_, work->len_, 0)                       \
+                : INTERNAL_DIGEST(hasher->state_);                            \
+      TYPE_PREFIX##canonicalFromHash(                                         \
+          (TYPE_PREFIX##canonical_t *)work->digest_, sum);                    \
+      work->digest_size_ = sizeof(TYPE_PREFIX##canonical_t);                  \
+   }                                                                          \
+                                                                              \
+   static void async_complete(napi_env env, napi_status status, void *data) { \
+      Async_Work_t *work = (Async_Work_t *)data;                              \
+      WRAPPER_TYPE *hasher = (WRAPPER_TYPE *)work->hasher_;                   \
+      async_work_finish(env, hasher != NULL ? &hasher->queue_ : NULL, work,   \
+                        status);                                              \
+   }                                                                          \
+                                                                              \
+   static napi_value hash_async(napi_env env, napi_callback_info info) {      \
       size_t argc = 1;                                                        \
       napi_value args[1];                                                     \
+      napi_value promise;                                                     \
+      Async_Work_t *work;                                                     \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
+      work = async_work_create(env, ASYNC_HASH, NULL, args[0], async_execute, \
+                               async_complete, &promise);                     \
+      if (work == NULL) {                                                     \
+         return promise;                                                      \
+      }                                                                       \
+      async_work_queue(env, NULL, work);                                      \
+      return promise;                                                         \
+   }                                                                          \
+                                                                              \
+   static napi_value update_async(napi_env env, napi_callback_info info) {    \
+      size_t argc = 1;                                                        \
+      napi_value args[1];                                                     \
+      napi_value jsthis;                                                      \
+      napi_value promise;                                                     \
+      WRAPPER_TYPE *hasher;                                                   \
+      Async_Work_t *work;                                                     \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);                \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      work = async_work_create(env, ASYNC_UPDATE, jsthis, args[0],            \
+                               async_execute, async_complete, &promise);      \
+      if (work == NULL) {                                                     \
+         return promise;                                                      \
+      }                                                                       \
+      work->hasher_ = hasher;                                                 \
+      async_work_queue(env, &hasher->queue_, work);                           \
+      return promise;                                                         \
+   }                                                                          \
+                                                                              \
+   static napi_value digest_async(napi_env env, napi_callback_info info) {    \
+      napi_value jsthis;                                                      \
+      napi_value promise;                                                     \
+      WRAPPER_TYPE *hasher;                                                   \
+      Async_Work_t *work;                                                     \
+                                                                              \
+      napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      work = async_work_create(env, ASYNC_DIGEST, jsthis, NULL,               \
+                               async_execute, async_complete, &promise);      \
+      if (work == NULL) {                                                     \
+         return promise;                                                      \
+      }                                                                       \
+      work->hasher_ = hasher;                                                 \
+      async_work_queue(env, &hasher->queue_, work);                           \
+      return promise;                                                         \
+   }                                                                          \
+                                                                              \
+   static napi_value hash_file_async(napi_env env, napi_callback_info info) { \
+      napi_value promise;                                                     \
+      Async_Work_t *work;                                                     \
+      char *path;                                                             \
+      uint64_t offset;                                                        \
+      uint64_t length;                                                        \
+                                                                              \
+      work = async_work_create(env, ASYNC_HASH_FILE, NULL, NULL,              \
+                               async_execute, async_complete, &promise);      \
+      if (get_file_args(env, info, &path, &offset, &length) != ADDON_OK) {    \
+         async_work_reject(env, work);                                        \
+         return promise;                                                      \
+      }                                                                       \
+      work->path_ = path;                                                     \
+      work->offset_ = offset;                                                 \
+      work->length_ = length;                                                 \
+      async_work_queue(env, NULL, work);                                      \
+      return promise;                                                         \
+   }
+
+/* hashParallel(data[, { chunkSize, threads }]) is a tree mode, not plain
+ * XXH3: data is cut into chunkSize chunks (an empty input is one empty
+ * chunk), each hashed with seed 0 into its canonical digest, and the root is
+ * the same hash of all chunk digests concatenated in order, seeded with
+ * chunkSize. The thread count only affects speed. */
+#define HASH_PARALLEL(TYPE_PREFIX, HASH_FUNC)                                 \
+   static void parallel_leaf(const void *data, size_t len,                    \
+                             unsigned char *out) {                            \
+      TYPE_PREFIX##canonicalFromHash((TYPE_PREFIX##canonical_t *)out,         \
+                                     HASH_FUNC(data, len, 0));                \
+   }                                                                          \
+                                                                              \
+   static napi_value hash_parallel(napi_env env, napi_callback_info info) {   \
+      size_t argc = 2;                                                        \
+      napi_value args[2];                                                     \
       napi_value result;                                                      \
-      void *data;                                                             \
-      size_t buf_len;                                                         \
+      Input_t input;                                                          \
+      size_t chunk_size;                                                      \
+      unsigned int threads;                                                   \
+      size_t leaves_len;                                                      \
+      unsigned char *leaves;                                                  \
       TYPE_PREFIX##hash_t sum;                                                \
       TYPE_PREFIX##canonical_t canonical_sum;                                 \
       TYPE_PREFIX##canonical_t *result_data;                                  \
                                                                               \
       napi_get_cb_info(env, info, &argc, args, NULL, NULL);                   \
-      if (type_check_data_buffer(env, args, argc) != ADDON_OK) {              \
+      if (get_parallel_options(env, argc > 1 ? args[1] : NULL, &chunk_size,   \
+                               &threads) != ADDON_OK ||                       \
+          get_input(env, args[0], &input) != ADDON_OK) {                      \
+         return NULL;                                                         \
+      }                                                                       \
+                                                                              \
+      leaves_len = parallel_chunk_count(input.len_, chunk_size) *             \
+                   sizeof(TYPE_PREFIX##canonical_t);                          \
+      leaves = malloc(leaves_len);                                            \
+      if (leaves == NULL) {                                                   \
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);           \
          return NULL;                                                         \
       }                                                                       \
-      napi_get_buffer_info(env, args[0], &data, &buf_len);                    \
-      sum = HASH_FUNC(data, buf_len, 0);                                      \
+      hash_parallel_leaves((const unsigned char *)input.data_, input.len_,    \
+                           chunk_size, threads, parallel_leaf,                \
+                           sizeof(TYPE_PREFIX##canonical_t), leaves);         \
+      sum = HASH_FUNC(leaves, leaves_len, (XXH64_hash_t)chunk_size);          \
+      free(leaves);                                                           \
+      RELEASE_INPUT(input)                                                    \
                                                                               \
       CANONICALIZE(TYPE_PREFIX)                                               \
       return result;                                                          \
@@ -127,6 +962,7 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
                                                                               \
       napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
       napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
                                                                               \
       xxError =                                                               \
           hasher->secret_ == NULL                                             \
@@ -148,6 +984,7 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
                                                                               \
       napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
       napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
                                                                               \
       xxError = INTERNAL_RESET(hasher->state_, hasher->seed_);                \
                                                                               \
@@ -157,6 +994,29 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
       return NULL;                                                            \
    }
 
+/* Hashers are allocated from and returned to their wrapper type's pool,
+ * state included; see pool.c. */
+#define ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                      \
+   obj = (WRAPPER_TYPE *)pool_get(&pool_##WRAPPER_TYPE);                      \
+   if (obj == NULL) {                                                         \
+      obj = calloc(1, sizeof(WRAPPER_TYPE));                                  \
+      if (obj == NULL || (obj->state_ = INTERNAL_CREATESTATE()) == NULL) {    \
+         free(obj);                                                           \
+         napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);           \
+         return NULL;                                                         \
+      }                                                                       \
+   }                                                                          \
+   obj->env_ = env;                                                           \
+   obj->wrapper_ = NULL;                                                      \
+   obj->queue_.head_ = NULL;                                                  \
+   obj->queue_.tail_ = NULL;
+
+#define RELEASE_HASHER(WRAPPER_TYPE, INTERNAL_FREESTATE)                      \
+   if (!pool_put(&pool_##WRAPPER_TYPE, hasher)) {                             \
+      INTERNAL_FREESTATE(hasher->state_);                                     \
+      free(hasher);                                                           \
+   }
+
 #define DESTROY3(WRAPPER_TYPE, INTERNAL_FREESTATE)                            \
    static void destroy(napi_env _unused_env, void *obj, void *_unused_hint) { \
       WRAPPER_TYPE *hasher = (WRAPPER_TYPE *)obj;                             \
@@ -166,12 +1026,8 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
          free(hasher->secret_);                                               \
          hasher->secret_ = NULL;                                              \
       }                                                                       \
-      if (hasher->state_ != NULL) {                                           \
-         INTERNAL_FREESTATE(hasher->state_);                                  \
-         hasher->state_ = NULL;                                               \
-      }                                                                       \
       napi_delete_reference(hasher->env_, hasher->wrapper_);                  \
-      free(hasher);                                                           \
+      RELEASE_HASHER(WRAPPER_TYPE, INTERNAL_FREESTATE)                        \
    }
 
 #define DESTROY(WRAPPER_TYPE, INTERNAL_FREESTATE)                             \
@@ -179,12 +1035,128 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
       WRAPPER_TYPE *hasher = (WRAPPER_TYPE *)obj;                             \
       (void)_unused_env;                                                      \
       (void)_unused_hint;                                                     \
-      if (hasher->state_ != NULL) {                                           \
-         INTERNAL_FREESTATE(hasher->state_);                                  \
-         hasher->state_ = NULL;                                               \
-      }                                                                       \
       napi_delete_reference(hasher->env_, hasher->wrapper_);                  \
-      free(hasher);                                                           \
+      RELEASE_HASHER(WRAPPER_TYPE, INTERNAL_FREESTATE)                        \
+   }
+
+/* clone() forks a hasher: the copy carries the state absorbed so far and
+ * continues independently. new_adopted_instance() runs the class
+ * constructor with adopted_ set in the class data, so COMMON_SETUP wraps
+ * the copy rather than making a hasher from a seed. cloneInto(target)
+ * copies into an existing hasher of the same class instead, which saves
+ * creating an object per fork. */
+#define CLONE_METHODS(WRAPPER_TYPE, INTERNAL_CREATESTATE)                     \
+   static napi_value clone(napi_env env, napi_callback_info info) {           \
+      napi_value jsthis;                                                      \
+      Class_data_t *class_data;                                               \
+      WRAPPER_TYPE *hasher;                                                   \
+      WRAPPER_TYPE *obj;                                                      \
+                                                                              \
+      napi_get_cb_info(env, info, NULL, NULL, &jsthis, (void **)&class_data); \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
+                                                                              \
+      ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                        \
+      copy_state(obj, hasher);                                                \
+      return new_adopted_instance(env, class_data, obj, destroy);             \
+   }                                                                          \
+                                                                              \
+   static napi_value clone_into(napi_env env, napi_callback_info info) {      \
+      size_t argc = 1;                                                        \
+      napi_value args[1];                                                     \
+      napi_value jsthis;                                                      \
+      napi_value cons;                                                        \
+      bool same_class = false;                                                \
+      Class_data_t *class_data;                                               \
+      WRAPPER_TYPE *hasher;                                                   \
+      WRAPPER_TYPE *target;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, &jsthis, (void **)&class_data);\
+      napi_get_reference_value(env, class_data->cons_, &cons);                \
+      if (argc < 1 ||                                                         \
+          napi_instanceof(env, args[0], cons, &same_class) != napi_ok ||      \
+          !same_class) {                                                      \
+         napi_throw_type_error(env, NULL,                                     \
+                               "Target must be a hasher of the same class");  \
+         return NULL;                                                         \
+      }                                                                       \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      napi_unwrap(env, args[0], (void **)&target);                            \
+      THROW_IF_BUSY(hasher)                                                   \
+      THROW_IF_BUSY(target)                                                   \
+                                                                              \
+      if (target != hasher) {                                                 \
+         copy_state(target, hasher);                                          \
+      }                                                                       \
+      return NULL;                                                            \
+   }
+
+/* XXH3 states point at their external secret, so the copy gets its own
+ * secret_ and its state is repointed at it. A secret of the same size is
+ * overwritten in place. */
+#define CLONE3(WRAPPER_TYPE, INTERNAL_CREATESTATE, INTERNAL_COPYSTATE)        \
+   static void copy_state(WRAPPER_TYPE *obj, const WRAPPER_TYPE *source) {    \
+      if (obj->secret_ != NULL &&                                             \
+          (source->secret_ == NULL ||                                         \
+           obj->secretSize_ != source->secretSize_)) {                        \
+         free(obj->secret_);                                                  \
+         obj->secret_ = NULL;                                                 \
+      }                                                                       \
+      if (source->secret_ != NULL && obj->secret_ == NULL) {                  \
+         obj->secret_ = malloc(source->secretSize_);                          \
+         if (obj->secret_ == NULL) {                                          \
+            napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);        \
+            return;                                                           \
+         }                                                                    \
+      }                                                                       \
+      INTERNAL_COPYSTATE(obj->state_, source->state_);                        \
+      obj->seed_ = source->seed_;                                             \
+      obj->secretSize_ = source->secretSize_;                                 \
+      if (source->secret_ != NULL) {                                          \
+         memcpy(obj->secret_, source->secret_, source->secretSize_);          \
+         obj->state_->extSecret = (const unsigned char *)obj->secret_;        \
+      }                                                                       \
+   }                                                                          \
+                                                                              \
+   CLONE_METHODS(WRAPPER_TYPE, INTERNAL_CREATESTATE)
+
+#define CLONE(WRAPPER_TYPE, INTERNAL_CREATESTATE, INTERNAL_COPYSTATE)         \
+   static void copy_state(WRAPPER_TYPE *obj, const WRAPPER_TYPE *source) {    \
+      INTERNAL_COPYSTATE(obj->state_, source->state_);                        \
+      obj->seed_ = source->seed_;                                             \
+   }                                                                          \
+                                                                              \
+   CLONE_METHODS(WRAPPER_TYPE, INTERNAL_CREATESTATE)
+
+/* exportState() serializes a hasher; the static importState(state) makes a
+ * new hasher from it. SUFFIX picks the 32, 64 or 3 (XXH3 family) functions
+ * of state.c, which define the format; ALGORITHM tags the class. */
+#define STATE(WRAPPER_TYPE, INTERNAL_CREATESTATE, SUFFIX, ALGORITHM)          \
+   static napi_value export_state(napi_env env, napi_callback_info info) {    \
+      napi_value jsthis;                                                      \
+      WRAPPER_TYPE *hasher;                                                   \
+                                                                              \
+      napi_get_cb_info(env, info, NULL, NULL, &jsthis, NULL);                 \
+      napi_unwrap(env, jsthis, (void **)&hasher);                             \
+      THROW_IF_BUSY(hasher)                                                   \
+                                                                              \
+      return export_state##SUFFIX(env, hasher, ALGORITHM);                    \
+   }                                                                          \
+                                                                              \
+   static napi_value import_state(napi_env env, napi_callback_info info) {    \
+      size_t argc = 1;                                                        \
+      napi_value args[1];                                                     \
+      Class_data_t *class_data;                                               \
+      WRAPPER_TYPE *obj;                                                      \
+                                                                              \
+      napi_get_cb_info(env, info, &argc, args, NULL, (void **)&class_data);   \
+      ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                        \
+      if (import_state##SUFFIX(env, argc < 1 ? NULL : args[0], obj,           \
+                               ALGORITHM) != ADDON_OK) {                      \
+         destroy(env, obj, NULL);                                             \
+         return NULL;                                                         \
+      }                                                                       \
+      return new_adopted_instance(env, class_data, obj, destroy);             \
    }
 
 #define COMMON_SETUP(WRAPPER_TYPE)                                            \
@@ -193,72 +1165,68 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
    napi_value jsthis;                                                         \
    size_t buf_len;                                                            \
    void *data;                                                                \
+   Class_data_t *class_data;                                                  \
    WRAPPER_TYPE *obj;                                                         \
                                                                               \
-   napi_get_cb_info(env, info, &argc, args, &jsthis, NULL);                   \
+   napi_get_cb_info(env, info, &argc, args, &jsthis, (void **)&class_data);   \
+   if (class_data->adopted_ != NULL) {                                        \
+      obj = (WRAPPER_TYPE *)class_data->adopted_;                             \
+      class_data->adopted_ = NULL;                                            \
+      COMMON_WRAP                                                             \
+      return jsthis;                                                          \
+   }                                                                          \
    if (type_check_data_buffer(env, args, argc) != ADDON_OK) {                 \
       return NULL;                                                            \
    }                                                                          \
    napi_get_buffer_info(env, args[0], &data, &buf_len);
 
+/* Seeds and secrets are validated before anything is allocated. */
 #define SET_UP_HASHER3(WRAPPER_TYPE, INTERNAL_CREATESTATE, INTERNAL_RESET)    \
-   obj = malloc(sizeof(WRAPPER_TYPE));                                        \
-   obj->state_ = INTERNAL_CREATESTATE();                                      \
+   if (buf_len != 4 && buf_len != 8 && buf_len < XXH3_SECRET_SIZE_MIN) {      \
+      napi_throw_error(                                                       \
+          env, NULL,                                                          \
+          "Secret must be >= " QUOTE(XXH3_SECRET_SIZE_MIN) " bytes");         \
+      return NULL;                                                            \
+   }                                                                          \
+   ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                           \
    obj->secret_ = NULL;                                                       \
-   obj->env_ = env;                                                           \
+   obj->secretSize_ = 0;                                                      \
    if (buf_len == 4) {                                                        \
       obj->seed_ = XXH32_hashFromCanonical((XXH32_canonical_t *)data);        \
       INTERNAL_RESET##_withSeed(obj->state_, obj->seed_);                     \
    } else if (buf_len == 8) {                                                 \
       obj->seed_ = XXH64_hashFromCanonical((XXH64_canonical_t *)data);        \
       INTERNAL_RESET##_withSeed(obj->state_, obj->seed_);                     \
-   } else if (buf_len >= XXH3_SECRET_SIZE_MIN) {                              \
+   } else {                                                                   \
       obj->secret_ = malloc(buf_len);                                         \
       if (obj->secret_ == NULL) {                                             \
-         free(obj);                                                           \
-         obj = NULL;                                                          \
          napi_fatal_error(NULL, 0, "Out-of-mem", NAPI_AUTO_LENGTH);           \
          return NULL;                                                         \
       }                                                                       \
       obj->secret_ = memcpy(obj->secret_, data, buf_len);                     \
       obj->secretSize_ = buf_len;                                             \
       INTERNAL_RESET##_withSecret(obj->state_, obj->secret_, buf_len);        \
-   } else {                                                                   \
-      free(obj);                                                              \
-      obj = NULL;                                                             \
-      napi_throw_error(                                                       \
-          env, NULL,                                                          \
-          "Secret must be >= " QUOTE(XXH3_SECRET_SIZE_MIN) " bytes");         \
-      return NULL;                                                            \
    }
 
 #define SET_UP_HASHER64(WRAPPER_TYPE, INTERNAL_CREATESTATE, INTERNAL_RESET)   \
-   obj = malloc(sizeof(WRAPPER_TYPE));                                        \
-   obj->state_ = INTERNAL_CREATESTATE();                                      \
-   obj->env_ = env;                                                           \
+   if (buf_len != 4 && buf_len != 8) {                                        \
+      napi_throw_error(env, NULL, "Seed must be 4 or 8 bytes");               \
+      return NULL;                                                            \
+   }                                                                          \
+   ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                           \
    if (buf_len == 4) {                                                        \
       obj->seed_ = XXH32_hashFromCanonical((XXH32_canonical_t *)data);        \
-      INTERNAL_RESET(obj->state_, obj->seed_);                                \
-   } else if (buf_len == 8) {                                                 \
-      obj->seed_ = XXH64_hashFromCanonical((XXH64_canonical_t *)data);        \
-      INTERNAL_RESET(obj->state_, obj->seed_);                                \
    } else {                                                                   \
-      free(obj);                                                              \
-      obj = NULL;                                                             \
-      napi_throw_error(env, NULL, "Seed must be 4 or 8 bytes");               \
-      return NULL;                                                            \
-   }
+      obj->seed_ = XXH64_hashFromCanonical((XXH64_canonical_t *)data);        \
+   }                                                                          \
+   INTERNAL_RESET(obj->state_, obj->seed_);
 
 #define SET_UP_HASHER32(WRAPPER_TYPE, INTERNAL_CREATESTATE, INTERNAL_RESET)   \
-   obj = malloc(sizeof(WRAPPER_TYPE));                                        \
-   obj->state_ = INTERNAL_CREATESTATE();                                      \
-   obj->env_ = env;                                                           \
    if (buf_len != 4) {                                                        \
-      free(obj);                                                              \
-      obj = NULL;                                                             \
       napi_throw_error(env, NULL, "Seed must be 4 bytes");                    \
       return NULL;                                                            \
    }                                                                          \
+   ALLOC_HASHER(WRAPPER_TYPE, INTERNAL_CREATESTATE)                           \
    obj->seed_ = XXH32_hashFromCanonical((XXH32_canonical_t *)data);           \
    INTERNAL_RESET(obj->state_, obj->seed_);
 
@@ -292,20 +1260,67 @@ static ADDON_errorcode type_check_data_buffer(napi_env env, napi_value args[],
       return jsthis;                                                          \
    }
 
+#define COMMON_PROPERTIES                                                     \
+   {"update", NULL, update, NULL, NULL, NULL, napi_default, NULL},            \
+       {"digest", NULL, digest, NULL, NULL, NULL, napi_default, NULL},        \
+       {"reset", NULL, reset, NULL, NULL, NULL, napi_default, NULL},          \
+       {"digestInto", NULL, digest_into, NULL, NULL, NULL, napi_default,      \
+        NULL},                                                                \
+       {digest_value_name, NULL, digest_value, NULL, NULL, NULL,              \
+        napi_default, NULL},                                                  \
+       {"updateAsync", NULL, update_async, NULL, NULL, NULL, napi_default,    \
+        NULL},                                                                \
+       {"digestAsync", NULL, digest_async, NULL, NULL, NULL, napi_default,    \
+        NULL},                                                                \
+       {"hash", NULL, hash, NULL, NULL, NULL, napi_static, NULL},             \
+       {"hashInto", NULL, hash_into, NULL, NULL, NULL, napi_static, NULL},    \
+       {hash_value_name, NULL, hash_value, NULL, NULL, NULL, napi_static,     \
+        NULL},                                                                \
+       {"hashBatch", NULL, hash_batch, NULL, NULL, NULL, napi_static, NULL},  \
+       {"hashColumns", NULL, hash_columns, NULL, NULL, NULL, napi_static,     \
+        NULL},                                                                \
+       {"hashAsync", NULL, hash_async, NULL, NULL, NULL, napi_static, NULL},  \
+       {"hashFile", NULL, hash_file, NULL, NULL, NULL, napi_static, NULL},    \
+       {"hashFileAsync", NULL, hash_file_async, NULL, NULL, NULL,             \
+        napi_static, NULL},                                                   \
+       {"clone", NULL, clone, NULL, NULL, NULL, napi_default, class_data},    \
+       {"cloneInto", NULL, clone_into, NULL, NULL, NULL, napi_default,        \
+        class_data},                                                          \
+       {"exportState", NULL, export_state, NULL, NULL, NULL, napi_default,    \
+        NULL},                                                                \
+       {"importState", NULL, import_state, NULL, NULL, NULL, napi_static,     \
+        class_data}
+
+/* CLASS_DATA, when not NULL, is handed to the constructor and keeps a
+ * reference to it. */
+#define DEFINE_CLASS(CLASSNAME, CLASS_DATA)                                   \
+   napi_value cons;                                                           \
+                                                                              \
+   napi_define_class(env, #CLASSNAME, NAPI_AUTO_LENGTH, create_instance,      \
+                     (CLASS_DATA), sizeof(properties) / sizeof(*properties),  \
+                     properties, &cons);                                      \
+   if ((CLASS_DATA) != NULL) {                                                \
+      napi_create_reference(env, cons, 1, &(CLASS_DATA)->cons_);              \
+   }                                                                          \
+   napi_set_named_property(env, exports, #CLASSNAME, cons);                   \
+   return exports;
+
 #define INIT(CLASSNAME)                                                       \
    napi_value init_##CLASSNAME(napi_env env, napi_value exports) {            \
+      Class_data_t *class_data = create_class_data(env);                      \
+      napi_property_descriptor properties[] = {COMMON_PROPERTIES};            \
+      DEFINE_CLASS(CLASSNAME, class_data)                                     \
+   }
+
+/* XXH3-family classes additionally get the hashParallel() tree mode. */
+#define INIT3(CLASSNAME)                                                      \
+   napi_value init_##CLASSNAME(napi_env env, napi_value exports) {            \
+      Class_data_t *class_data = create_class_data(env);                      \
       napi_property_descriptor properties[] = {                               \
-          {"update", NULL, update, NULL, NULL, NULL, napi_default, NULL},     \
-          {"digest", NULL, digest, NULL, NULL, NULL, napi_default, NULL},     \
-          {"reset", NULL, reset, NULL, NULL, NULL, napi_default, NULL},       \
-          {"hash", NULL, hash, NULL, NULL, NULL, napi_static, NULL}};         \
-      napi_value cons;                                                        \
-                                                                              \
-      napi_define_class(env, #CLASSNAME, NAPI_AUTO_LENGTH, create_instance,   \
-                        NULL, sizeof(properties) / sizeof(*properties),       \
-                        properties, &cons);                                   \
-      napi_set_named_property(env, exports, #CLASSNAME, cons);                \
-      return exports;                                                         \
+          COMMON_PROPERTIES,                                                  \
+          {"hashParallel", NULL, hash_parallel, NULL, NULL, NULL,             \
+           napi_static, NULL}};                                               \
+      DEFINE_CLASS(CLASSNAME, class_data)                                     \
    }
 
 #define DECLARE_INIT(CLASSNAME)                                               \
@@ -317,12 +1332,20 @@ DECLARE_INIT(XXHash128)
 DECLARE_INIT(XXHash3)
 DECLARE_INIT(XXHash64)
 DECLARE_INIT(XXHash32)
+DECLARE_INIT(XXH3Secret)
+DECLARE_INIT(Chunker)
+DECLARE_INIT(XXH3BloomFilter)
+DECLARE_INIT(XXH3HashSet)
+DECLARE_INIT(Baseline)
+DECLARE_INIT(Stats)
+DECLARE_INIT(Simd)
 
 typedef struct {
    napi_env env_;
    napi_ref wrapper_;
    XXH64_hash_t seed_;
    XXH3_state_t *state_;
+   Async_Queue_t queue_;
    void *secret_;
    size_t secretSize_;
 } XXHash3_Wrapper_t;
@@ -332,6 +1355,7 @@ typedef struct {
    napi_ref wrapper_;
    XXH64_hash_t seed_;
    XXH64_state_t *state_;
+   Async_Queue_t queue_;
 } XXHash64_Wrapper_t;
 
 typedef struct {
@@ -339,6 +1363,119 @@ typedef struct {
    napi_ref wrapper_;
    XXH32_hash_t seed_;
    XXH32_state_t *state_;
+   Async_Queue_t queue_;
 } XXHash32_Wrapper_t;
 
+/* The secret_ is stored 64-byte aligned in the same allocation, right after
+ * the wrapper. */
+typedef struct {
+   napi_env env_;
+   napi_ref wrapper_;
+   XXH64_hash_t seed_;
+   int fromSeed_;
+   unsigned char *secret_;
+   size_t secretSize_;
+} XXH3Secret_Wrapper_t;
+
+/* exportState()/importState() serialization; defined in state.c. */
+typedef enum {
+   STATE_XXH32 = 1,
+   STATE_XXH64,
+   STATE_XXH3,
+   STATE_XXH128,
+   STATE_BLOOM,
+   STATE_HASHSET
+} STATE_algorithm;
+napi_value export_state32(napi_env env, const XXHash32_Wrapper_t *hasher,
+                          STATE_algorithm algorithm);
+ADDON_errorcode import_state32(napi_env env, napi_value value,
+                               XXHash32_Wrapper_t *obj,
+                               STATE_algorithm algorithm);
+napi_value export_state64(napi_env env, const XXHash64_Wrapper_t *hasher,
+                          STATE_algorithm algorithm);
+ADDON_errorcode import_state64(napi_env env, napi_value value,
+                               XXHash64_Wrapper_t *obj,
+                               STATE_algorithm algorithm);
+napi_value export_state3(napi_env env, const XXHash3_Wrapper_t *hasher,
+                         STATE_algorithm algorithm);
+ADDON_errorcode import_state3(napi_env env, napi_value value,
+                              XXHash3_Wrapper_t *obj,
+                              STATE_algorithm algorithm);
+
+/* The framing of every exported state, for classes that lay out their own
+ * payload: open_state() returns where the payload goes, STATE_HEADER_SIZE
+ * bytes into the Buffer; seal_state() appends the checksum. open_import()
+ * checks a state and returns its payload, which the caller parses with the
+ * little-endian get_u32()/get_u64() and hands back with RELEASE_INPUT or
+ * state_corrupt(). */
+#define STATE_HEADER_SIZE 8
+unsigned char *open_state(napi_env env, STATE_algorithm algorithm,
+                          size_t payload_size, napi_value *result);
+void seal_state(unsigned char *start, unsigned char *end);
+const unsigned char *open_import(napi_env env, napi_value value,
+                                 STATE_algorithm algorithm, Input_t *input,
+                                 size_t *payload_size);
+ADDON_errorcode state_corrupt(napi_env env, Input_t *input);
+unsigned char *put_u32(unsigned char *p, XXH32_hash_t value);
+unsigned char *put_u64(unsigned char *p, XXH64_hash_t value);
+XXH32_hash_t get_u32(const unsigned char **p);
+XXH64_hash_t get_u64(const unsigned char **p);
+
+/* A content-defined chunker; see chunker_addon.c. pos_ and fp_ are the
+ * current chunk's length so far and rolling hash, offset_ its start in the
+ * stream. state_ digests a chunk that spans update() calls (streaming_).
+ * Finished chunks collect in the offsets_/lengths_/digests_ arrays until
+ * they are handed to JS. */
+typedef struct {
+   napi_env env_;
+   napi_ref wrapper_;
+   XXH64_hash_t seed_;
+   int wide_;
+   size_t minSize_;
+   size_t avgSize_;
+   size_t maxSize_;
+   uint64_t maskS_;
+   uint64_t maskL_;
+   uint64_t fp_;
+   size_t pos_;
+   uint64_t offset_;
+   XXH3_state_t *state_;
+   int streaming_;
+   double *offsets_;
+   uint32_t *lengths_;
+   unsigned char *digests_;
+   size_t count_;
+   size_t capacity_;
+} Chunker_Wrapper_t;
+
+/* A blocked Bloom filter; see bloom_addon.c. bits_ is blocks_ 64-byte
+ * blocks, cache-line aligned inside alloc_; every key sets hashes_ bits in
+ * one block. */
+typedef struct {
+   napi_env env_;
+   napi_ref wrapper_;
+   XXH64_hash_t seed_;
+   uint32_t hashes_;
+   uint64_t blocks_;
+   uint64_t *bits_;
+   void *alloc_;
+} XXH3BloomFilter_Wrapper_t;
+
+/* A set of 64-bit XXH3 hashes; see hashset_addon.c. slots_ is buckets_
+ * 64-byte buckets of 8 hashes, cache-line aligned inside alloc_; 0 marks a
+ * free slot. */
+typedef struct {
+   napi_env env_;
+   napi_ref wrapper_;
+   XXH64_hash_t seed_;
+   uint64_t *slots_;
+   void *alloc_;
+   uint64_t buckets_;
+   uint64_t size_;
+} XXH3HashSet_Wrapper_t;
+
+/* Returns the native side of an XXH3Secret, or NULL when value is not one;
+ * defined in xxh3secret_addon.c. */
+XXH3Secret_Wrapper_t *get_xxh3_secret(napi_env env, napi_value value);
+
 #endif /* XXHASH_ADDON_H_ */
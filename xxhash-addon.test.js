@@ -1,6 +1,11 @@
 'use strict';
 const assert = require('assert');
-const { XXHash32, XXHash64, XXHash3, XXHash128 } = require('./xxhash-addon');
+const crypto = require('crypto');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const childProcess = require('child_process');
+const { XXHash32, XXHash64, XXHash3, XXHash128, XXH3Secret, Chunker, XXH3BloomFilter, XXH3HashSet, getSimdBackend, setSimdBackend, listSimdBackends, _nativeHashLoop, getStats, resetStats, enableStats, disableStats } = require('./xxhash-addon');
 
 const sanityBuffer = Buffer.from([
   0x00, 0x52, 0x92, 0x9b, 0xb7, 0x32, 0xa3, 0x24,
@@ -385,4 +390,792 @@ hasher128Seeded.update(sanityBuffer.slice(0, 1));
 hasher128Seeded.update(Buffer.alloc(0));
 assert.strictEqual(hex(hasher128Seeded.digest()), '89B99554BA22467CB53D5557E7F76F8D');
 
-console.log('\nAll tests passed.');
+// ── Allocation-free results ──
+
+console.log('digestInto/hashInto and numeric results');
+for (const [Cls, seedBuf, size] of [[XXHash32, buf_seed, 4], [XXHash64, buf_seed, 8], [XXHash3, big_seed, 8], [XXHash128, buf_seed, 16]]) {
+  const data = sanityBuffer.slice(0, 222);
+  const expected = Cls.hash(data);
+  const toValue = size === 4 ? (b) => b.readUInt32BE(0) : (b) => BigInt('0x' + b.toString('hex'));
+
+  const out = Buffer.alloc(size + 3, 0xff);
+  assert.strictEqual(Cls.hashInto(data, out, 3), size + 3);
+  assert.deepStrictEqual(out.subarray(3), expected);
+  assert.strictEqual(out[2], 0xff);
+  assert.strictEqual(Cls.hashInto(data, out), size);
+  assert.deepStrictEqual(out.subarray(0, size), expected);
+  assert.throws(() => Cls.hashInto(data, out, 4), RangeError);
+  assert.throws(() => Cls.hashInto(data, Buffer.alloc(size - 1)), RangeError);
+  assert.throws(() => Cls.hashInto(data, 'out'), TypeError);
+  assert.throws(() => Cls.hashInto(data, {}), TypeError);
+  // Offsets are not coerced: no truncation, no wrap-around, no NaN as 0.
+  for (const bad of [-1, 1.5, NaN, Infinity, 2 ** 32]) {
+    assert.throws(() => Cls.hashInto(data, out, bad), { name: 'RangeError', message: bad === 2 ** 32 ? 'Output is too small' : 'Offset must be an integer >= 0' }, String(bad));
+  }
+  assert.throws(() => Cls.hashInto(data, out, '1'), TypeError);
+  const view = new Uint8Array(size);
+  assert.strictEqual(Cls.hashInto(data, view), size);
+  assert.deepStrictEqual(Buffer.from(view), expected);
+
+  const valueName = size === 4 ? 'Number' : 'BigInt';
+  assert.strictEqual(Cls['hash' + valueName](data), toValue(expected));
+
+  const hasher = new Cls(seedBuf);
+  hasher.update(data);
+  const digest = hasher.digest();
+  out.fill(0);
+  assert.strictEqual(hasher.digestInto(out, 1), size + 1);
+  assert.deepStrictEqual(out.subarray(1, size + 1), digest);
+  assert.throws(() => hasher.digestInto(out, size + 2), RangeError);
+  assert.throws(() => hasher.digestInto(42), TypeError);
+  assert.throws(() => hasher.digestInto({ length: size }), TypeError);
+  for (const bad of [-1, 0.5, NaN]) {
+    assert.throws(() => hasher.digestInto(out, bad), { name: 'RangeError', message: 'Offset must be an integer >= 0' }, String(bad));
+  }
+  assert.strictEqual(hasher['digest' + valueName](), toValue(digest));
+}
+assert.strictEqual(typeof XXHash32.hashNumber(sanityBuffer), 'number');
+assert.strictEqual(typeof XXHash64.hashBigInt(sanityBuffer), 'bigint');
+assert.strictEqual(XXHash32.hashBigInt, undefined);
+
+// ── Batch one-shot hashing ──
+
+console.log('hashBatch - array of buffers and offsets');
+{
+  const records = [0, 1, 17, 222, 0, 2240].map((len, i) => sanityBuffer.slice(i, i + len));
+  const offsets = new Uint32Array(records.length + 1);
+  for (let i = 0; i < records.length; i++) offsets[i + 1] = offsets[i] + records[i].length;
+  const packed = Buffer.concat(records);
+
+  for (const [Cls, size] of [[XXHash32, 4], [XXHash64, 8], [XXHash3, 8], [XXHash128, 16]]) {
+    const expected = Buffer.concat(records.map((r) => Cls.hash(r)));
+    assert.deepStrictEqual(Cls.hashBatch(records), expected);
+    assert.deepStrictEqual(Cls.hashBatch(packed, offsets), expected);
+
+    const out = Buffer.alloc(expected.length + size);
+    assert.strictEqual(Cls.hashBatch(records, out), out);
+    assert.deepStrictEqual(out.subarray(0, expected.length), expected);
+
+    const lanes = size === 4
+      ? new Uint32Array(records.length)
+      : new BigUint64Array(records.length * size / 8);
+    Cls.hashBatch(packed, offsets, lanes);
+    const native = Buffer.alloc(expected.length);
+    for (let i = 0; i < lanes.length; i++) {
+      if (size === 4) native.writeUInt32BE(lanes[i], i * 4);
+      else native.writeBigUInt64BE(lanes[i], i * 8);
+    }
+    assert.deepStrictEqual(native, expected);
+
+    assert.strictEqual(Cls.hashBatch([]).length, 0);
+    assert.throws(() => Cls.hashBatch(records, Buffer.alloc(expected.length - 1)), RangeError);
+    assert.throws(() => Cls.hashBatch(packed, new Uint32Array([0, packed.length + 1])), RangeError);
+    assert.throws(() => Cls.hashBatch(packed, new Uint32Array([2, 1])), RangeError);
+    assert.throws(() => Cls.hashBatch(packed, [0, 1]), TypeError);
+
+    // A getter that detaches out while the records are read must not leave
+    // hashBatch() writing into the freed buffer.
+    if (typeof structuredClone === 'function') {
+      const detached = new Uint8Array(expected.length);
+      const tricky = records.slice();
+      Object.defineProperty(tricky, 1, {
+        get() { structuredClone(detached.buffer, { transfer: [detached.buffer] }); return records[1]; },
+      });
+      assert.throws(() => Cls.hashBatch(tricky, detached), RangeError);
+    }
+  }
+}
+
+// ── Parallel (tree) hashing ──
+
+console.log('hashParallel - reproducible tree format, independent of thread count');
+{
+  const data = Buffer.alloc(200 * 1024 + 17);
+  for (let i = 0; i < data.length; i += sanityBuffer.length) sanityBuffer.copy(data, i);
+
+  // Reference implementation of the documented format.
+  function treeHash(Cls, input, chunkSize) {
+    const leaves = [];
+    for (let i = 0; i === 0 || i < input.length; i += chunkSize) {
+      leaves.push(Cls.hash(input.subarray(i, i + chunkSize)));
+    }
+    const seedBuf = Buffer.alloc(8);
+    seedBuf.writeBigUInt64BE(BigInt(chunkSize));
+    const root = new Cls(seedBuf);
+    root.update(Buffer.concat(leaves));
+    return root.digest();
+  }
+
+  for (const Cls of [XXHash3, XXHash128]) {
+    for (const chunkSize of [1024, 4096, 65536, 1 << 20]) {
+      const expected = treeHash(Cls, data, chunkSize);
+      for (const threads of [1, 2, 3, 8, 1000]) {
+        assert.deepStrictEqual(Cls.hashParallel(data, { chunkSize, threads }), expected);
+      }
+    }
+    assert.deepStrictEqual(Cls.hashParallel(data), treeHash(Cls, data, 1 << 20));
+    assert.deepStrictEqual(Cls.hashParallel(Buffer.alloc(0), { threads: 4 }), treeHash(Cls, Buffer.alloc(0), 1 << 20));
+    assert.throws(() => Cls.hashParallel(data, { chunkSize: 1023 }), RangeError);
+    assert.throws(() => Cls.hashParallel(data, { threads: 0 }), RangeError);
+    assert.throws(() => Cls.hashParallel(data, 4), TypeError);
+  }
+  assert.strictEqual(XXHash64.hashParallel, undefined);
+}
+
+// ── Strings and other input types ──
+
+console.log('Strings, typed arrays, DataViews and ArrayBuffers as input');
+for (const [Cls, seedBuf] of [[XXHash32, buf_seed], [XXHash64, buf_seed], [XXHash3, big_seed], [XXHash128, buf_seed]]) {
+  // Short strings are encoded on the stack, long ones (> 170 UTF-16 units) on the heap.
+  for (const str of ['', 'xxhash', 'héllo wörld ✓ 😀', 'a'.repeat(169), 'a'.repeat(170), '😀'.repeat(1000), '\ud800 lone']) {
+    assert.deepStrictEqual(Cls.hash(str), Cls.hash(Buffer.from(str)));
+  }
+
+  const bytes = sanityBuffer.slice(0, 96);
+  const copy = new Uint8Array(bytes).buffer;
+  const expected = Cls.hash(bytes);
+  assert.deepStrictEqual(Cls.hash(copy), expected);
+  assert.deepStrictEqual(Cls.hash(new Uint32Array(copy)), expected);
+  assert.deepStrictEqual(Cls.hash(new DataView(copy)), expected);
+  assert.deepStrictEqual(Cls.hash(new Float64Array(copy, 16, 4)), Cls.hash(bytes.slice(16, 48)));
+  assert.deepStrictEqual(Cls.hash(new DataView(copy, 5, 7)), Cls.hash(bytes.slice(5, 12)));
+  assert.deepStrictEqual(Cls.hash(new BigUint64Array(copy, 8, 2)), Cls.hash(bytes.slice(8, 24)));
+  assert.deepStrictEqual(Cls.hash(new Uint8Array(copy, 3, 5)), Cls.hash(bytes.slice(3, 8)));
+
+  const hasher = new Cls(seedBuf);
+  hasher.update('héllo ');
+  hasher.update(new Uint16Array(new Uint8Array(Buffer.from('wörld!')).buffer, 0, 3));
+  hasher.update(new ArrayBuffer(0));
+  const reference = new Cls(seedBuf);
+  reference.update(Buffer.from('héllo wörld'));
+  assert.deepStrictEqual(hasher.digest(), reference.digest());
+
+  assert.deepStrictEqual(Cls.hashBatch(['a', new Uint8Array([98]).buffer]), Cls.hashBatch([Buffer.from('a'), Buffer.from('b')]));
+  assert.throws(() => Cls.hash(42), TypeError);
+  assert.throws(() => Cls.hash(), TypeError);
+  assert.throws(() => Cls.hash({ length: 4 }), TypeError);
+  assert.throws(() => Cls.hash({}), TypeError);
+  assert.throws(() => hasher.update(null), TypeError);
+  assert.throws(() => Cls.hashBatch([Buffer.alloc(1), 1]), TypeError);
+}
+
+// ── Seeded and secret one-shot hashing ──
+
+console.log('hash(data, seedOrSecret) - seeds, secrets and XXH3Secret');
+{
+  const streamed = (Cls, key, data) => {
+    const h = new Cls(key);
+    h.update(data);
+    return h.digest();
+  };
+  // 100 bytes exercise the short-input path, 2240 bytes the long one.
+  for (const data of [sanityBuffer.slice(0, 100), sanityBuffer.slice(0, 2240)]) {
+    for (const Cls of [XXHash32, XXHash64, XXHash3, XXHash128]) {
+      const expected = streamed(Cls, buf_seed, data);
+      assert.deepStrictEqual(Cls.hash(data, seed), expected);
+      assert.deepStrictEqual(Cls.hash(data, BigInt(seed)), expected);
+      assert.deepStrictEqual(Cls.hash(data, buf_seed), expected);
+      assert.deepStrictEqual(Cls.hash(data, 0), Cls.hash(data));
+      assert.deepStrictEqual(Cls.hash(data, undefined), Cls.hash(data));
+      const value = Cls === XXHash32 ? Cls.hashNumber(data, seed) : Cls.hashBigInt(data, seed);
+      assert.strictEqual(value.toString(16).padStart(expected.length * 2, '0'), expected.toString('hex'));
+    }
+    for (const Cls of [XXHash64, XXHash3, XXHash128]) {
+      const expected = streamed(Cls, big_seed, data);
+      assert.deepStrictEqual(Cls.hash(data, 11400714785074694797n), expected);
+      assert.deepStrictEqual(Cls.hash(data, big_seed), expected);
+    }
+    for (const Cls of [XXHash3, XXHash128]) {
+      assert.deepStrictEqual(Cls.hash(data, secret), streamed(Cls, secret, data));
+
+      // A secret generated from a seed hashes like the seed itself.
+      const fromSeed = new XXH3Secret(11400714785074694797n);
+      assert.strictEqual(fromSeed.size, 192);
+      assert.deepStrictEqual(Cls.hash(data, fromSeed), Cls.hash(data, big_seed));
+      assert.deepStrictEqual(Cls.hash(data, new XXH3Secret(seed)), Cls.hash(data, seed));
+
+      // One generated from entropy matches its own bytes used as a secret.
+      const fromEntropy = new XXH3Secret('some entropy', 200);
+      assert.strictEqual(fromEntropy.size, 200);
+      assert.deepStrictEqual(Cls.hash(data, fromEntropy), Cls.hash(data, fromEntropy.toBuffer()));
+      assert.deepStrictEqual(Cls.hash(data, fromEntropy), streamed(Cls, fromEntropy.toBuffer(), data));
+      assert.deepStrictEqual(new XXH3Secret(Buffer.from('some entropy')).toBuffer(), new XXH3Secret('some entropy').toBuffer());
+    }
+  }
+
+  assert.throws(() => XXHash32.hash(sanityBuffer, 2 ** 32), RangeError);
+  assert.throws(() => XXHash32.hash(sanityBuffer, big_seed), /Seed must be 4 bytes/);
+  assert.throws(() => XXHash32.hash(sanityBuffer, new XXH3Secret(1)), TypeError);
+  assert.throws(() => XXHash64.hash(sanityBuffer, -1), RangeError);
+  assert.throws(() => XXHash64.hash(sanityBuffer, 1.5), RangeError);
+  assert.throws(() => XXHash64.hash(sanityBuffer, 2 ** 64), RangeError);
+  assert.throws(() => XXHash64.hash(sanityBuffer, 2n ** 64n), RangeError);
+  assert.throws(() => XXHash64.hash(sanityBuffer, secret), /Seed must be 4 or 8 bytes/);
+  assert.throws(() => XXHash3.hash(sanityBuffer, Buffer.alloc(16)), /Secret must be >= 136 bytes/);
+  assert.throws(() => XXHash3.hash(sanityBuffer, 'seed'), TypeError);
+  for (const Cls of [XXHash32, XXHash64, XXHash3, XXHash128]) {
+    assert.throws(() => Cls.hash(sanityBuffer, {}), TypeError);
+    assert.throws(() => Cls.hash(sanityBuffer, null), TypeError);
+  }
+  assert.throws(() => XXHash3.hash(sanityBuffer, new XXHash3(buf_seed)), TypeError);
+  assert.throws(() => new XXH3Secret('x', 100), RangeError);
+  assert.throws(() => new XXH3Secret(), TypeError);
+}
+
+// ── Columnar hashing ──
+
+console.log('hashColumns - per-row hashes of typed-array and string columns');
+{
+  const rowCount = 1000; // spans several native blocks of rows
+  const ids = new Int32Array(rowCount).map((_, i) => i * 7919 - 5000);
+  const prices = new Float64Array(rowCount).map((_, i) => i / 3);
+  const big = new BigInt64Array(rowCount).map((_, i) => BigInt(i) << 40n);
+  const flags = new Uint8Array(rowCount).map((_, i) => i & 1);
+  const shorts = new Uint16Array(rowCount + 5).map((_, i) => i * 3);
+  const names = Array.from({ length: rowCount }, (_, i) => 'name-' + 'x'.repeat(i % 37) + i);
+  const text = { data: Buffer.from(names.join('')), offsets: new Uint32Array(rowCount + 1) };
+  names.reduce((end, name, i) => (text.offsets[i + 1] = end + Buffer.byteLength(name)), 0);
+
+  // Reference: the row key spelled out in JS, hashed with hash().
+  const rowKey = (columns, i) => Buffer.concat(columns.map((col) => {
+    if (ArrayBuffer.isView(col)) {
+      return Buffer.from(col.buffer, col.byteOffset + i * col.BYTES_PER_ELEMENT, col.BYTES_PER_ELEMENT);
+    }
+    const bytes = col.data.subarray(col.offsets[i], col.offsets[i + 1]);
+    const len = Buffer.alloc(4);
+    len.writeUInt32LE(bytes.length);
+    return Buffer.concat([len, bytes]);
+  }));
+
+  const layouts = [[ids], [flags], [big], [ids, prices], [shorts, flags, big], [text], [ids, text, prices]];
+  for (const [Cls, seed, Lanes] of [[XXHash32, 42, Uint32Array], [XXHash64, 42n, BigUint64Array], [XXHash3, 42n, BigUint64Array], [XXHash128, 42n, BigUint64Array]]) {
+    for (const columns of layouts) {
+      const hashes = Cls.hashColumns(columns, rowCount, seed);
+      assert.ok(hashes instanceof Lanes);
+      const expected = Buffer.concat(Array.from({ length: rowCount }, (_, i) => Cls.hash(rowKey(columns, i), seed)));
+      assert.deepStrictEqual(Cls.hashColumns(columns, rowCount, seed, Buffer.alloc(expected.length)), expected);
+      if (Cls === XXHash32) assert.strictEqual(hashes[7], Cls.hashNumber(rowKey(columns, 7), seed));
+      if (Cls !== XXHash32 && Cls !== XXHash128) assert.strictEqual(hashes[7], Cls.hashBigInt(rowKey(columns, 7), seed));
+      if (Cls === XXHash128) assert.strictEqual(hashes[14] << 64n | hashes[15], Cls.hashBigInt(rowKey(columns, 7), seed));
+    }
+  }
+  // Fewer rows than the columns hold, and no rows at all.
+  assert.strictEqual(XXHash64.hashColumns([shorts], 3)[2], XXHash64.hashBigInt(Buffer.from([6, 0])));
+  assert.strictEqual(XXHash3.hashColumns([ids, text], 0).length, 0);
+  // The seed defaults to zero; XXH3 also takes a secret.
+  assert.deepStrictEqual(XXHash3.hashColumns([ids], 10), XXHash3.hashColumns([ids], 10, 0));
+  assert.strictEqual(XXHash3.hashColumns([ids], 10, secret)[3], XXHash3.hashBigInt(rowKey([ids], 3), secret));
+
+  assert.throws(() => XXHash64.hashColumns([ids], rowCount + 1), /shorter than rowCount/);
+  assert.throws(() => XXHash64.hashColumns([text], rowCount + 1), /shorter than rowCount/);
+  assert.throws(() => XXHash64.hashColumns([], 1), RangeError);
+  assert.throws(() => XXHash64.hashColumns(ids, 1), TypeError);
+  assert.throws(() => XXHash64.hashColumns([new DataView(ids.buffer)], 1), TypeError);
+  assert.throws(() => XXHash64.hashColumns([{ data: text.data, offsets: [0, 1] }], 1), TypeError);
+  for (const data of ['ab', { length: 2 }, 2, null]) {
+    assert.throws(() => XXHash64.hashColumns([{ data, offsets: new Uint32Array([0, 1]) }], 1), TypeError);
+  }
+  assert.throws(() => XXHash64.hashColumns([ids], -1), RangeError);
+  assert.throws(() => XXHash64.hashColumns([ids]), RangeError);
+  assert.throws(() => XXHash64.hashColumns([ids], 4, 0, new Uint32Array(4)), TypeError);
+  assert.throws(() => XXHash64.hashColumns([ids], 4, 0, new BigUint64Array(3)), /too small/);
+}
+
+// ── Content-defined chunking ──
+
+console.log('Chunker - FastCDC boundaries with per-chunk digests');
+{
+  // Reference FastCDC in JS, 64-bit Gear hash kept as two uint32 halves.
+  const gearHi = new Uint32Array(256);
+  const gearLo = new Uint32Array(256);
+  for (let b = 0; b < 256; b++) {
+    const g = XXHash64.hashBigInt(Buffer.from([b]));
+    gearHi[b] = Number(g >> 32n);
+    gearLo[b] = Number(g & 0xffffffffn);
+  }
+  const refCut = (data, min, avg, max) => {
+    if (data.length <= min) return data.length;
+    const bits = Math.floor(Math.log2(avg));
+    const maskS = (0xffffffff << (32 - bits - 2)) >>> 0;
+    const maskL = (0xffffffff << (32 - bits + 2)) >>> 0;
+    const end = Math.min(max, data.length);
+    let hi = 0;
+    let lo = 0;
+    for (let i = min; i < end; i++) {
+      const sum = ((lo << 1) >>> 0) + gearLo[data[i]];
+      hi = (((hi << 1) | (lo >>> 31)) + gearHi[data[i]] + (sum > 0xffffffff ? 1 : 0)) >>> 0;
+      lo = sum >>> 0;
+      if ((hi & (i < avg ? maskS : maskL)) === 0) return i + 1;
+    }
+    return end;
+  };
+  const refChunks = (data, min = 2048, avg = 8192, max = 65536) => {
+    const lengths = [];
+    for (let start = 0; start < data.length; start += lengths[lengths.length - 1]) {
+      lengths.push(refCut(data.subarray(start), min, avg, max));
+    }
+    return lengths;
+  };
+  const collect = (chunker, pieces) => {
+    const batches = pieces.map((piece) => chunker.update(piece)).concat([chunker.finish()]);
+    return {
+      offsets: batches.flatMap((b) => Array.from(b.offsets)),
+      lengths: batches.flatMap((b) => Array.from(b.lengths)),
+      digests: Buffer.concat(batches.map((b) => b.digests)),
+    };
+  };
+
+  const data = crypto.randomBytes(300000);
+  const lengths = refChunks(data);
+  const offsets = lengths.map((_, i) => lengths.slice(0, i).reduce((a, b) => a + b, 0));
+  const digests = Buffer.concat(offsets.map((o, i) => XXHash128.hash(data.subarray(o, o + lengths[i]))));
+
+  const chunker = new Chunker();
+  const whole = collect(chunker, [data]);
+  assert.deepStrictEqual(whole.lengths, lengths);
+  assert.deepStrictEqual(whole.offsets, offsets);
+  assert.deepStrictEqual(whole.digests, digests);
+  assert.ok(lengths.length > 10);
+
+  // Chunks spanning update() calls, and a reused chunker, give the same records.
+  const pieces = [];
+  for (let at = 0, step = 1; at < data.length; at += step, step = step * 7 % 9973 + 1) {
+    pieces.push(data.subarray(at, at + step));
+  }
+  assert.deepStrictEqual(collect(chunker, pieces), whole);
+
+  // Options: sizes, XXH3 digests and a seed.
+  const small = new Chunker({ minSize: 256, avgSize: 1024, maxSize: 4096, algorithm: 'xxh3', seed: 7 });
+  const out = collect(small, [data.subarray(0, 100000)]);
+  assert.deepStrictEqual(out.lengths, refChunks(data.subarray(0, 100000), 256, 1024, 4096));
+  assert.ok(out.lengths.slice(0, -1).every((len) => len >= 256 && len <= 4096));
+  assert.deepStrictEqual(out.digests.subarray(8, 16), XXHash3.hash(data.subarray(out.offsets[1], out.offsets[1] + out.lengths[1]), 7));
+
+  // An insertion only disturbs the chunks around it.
+  const edited = Buffer.concat([data.subarray(0, 1000), Buffer.from('x'), data.subarray(1000)]);
+  const before = new Set(whole.lengths.map((_, i) => whole.digests.toString('hex', i * 16, i * 16 + 16)));
+  const after = collect(chunker, [edited]);
+  const shared = after.lengths.filter((_, i) => before.has(after.digests.toString('hex', i * 16, i * 16 + 16))).length;
+  assert.ok(shared >= after.lengths.length - 3);
+
+  const empty = new Chunker().finish();
+  assert.strictEqual(empty.lengths.length, 0);
+  assert.strictEqual(empty.digests.length, 0);
+  assert.throws(() => new Chunker({ minSize: 8 }), RangeError);
+  assert.throws(() => new Chunker({ minSize: 4096, avgSize: 1024 }), RangeError);
+  assert.throws(() => new Chunker({ algorithm: 'md5' }), TypeError);
+  assert.throws(() => new Chunker(5), TypeError);
+  assert.throws(() => chunker.update(), RangeError);
+}
+
+// ── Membership structures ──
+
+console.log('XXH3BloomFilter/XXH3HashSet - batched membership, export and import');
+{
+  const keys = Array.from({ length: 20000 }, (_, i) => `event-${i}`);
+  const absent = Array.from({ length: 100000 }, (_, i) => `other-${i}`);
+  const pack = (list) => {
+    const parts = list.map((k) => Buffer.from(k));
+    const offsets = new Uint32Array(parts.length + 1);
+    parts.forEach((p, i) => { offsets[i + 1] = offsets[i] + p.length; });
+    return [Buffer.concat(parts), offsets];
+  };
+
+  const filter = new XXH3BloomFilter(keys.length, 0.01);
+  assert.strictEqual(filter.add(keys[0]), true);
+  assert.strictEqual(filter.add(keys[0]), false);
+  assert.strictEqual(filter.has(keys[0]), true);
+  assert.strictEqual(filter.addMany(keys.slice(1)).length, keys.length - 1);
+  assert.ok(filter.hasMany(keys).every((v) => v === 1));
+  assert.deepStrictEqual(filter.hasMany(...pack(keys)), filter.hasMany(keys));
+  const falsePositives = filter.hasMany(absent).reduce((a, b) => a + b, 0);
+  assert.ok(falsePositives < absent.length * 0.02, `${falsePositives} false positives`);
+  assert.strictEqual(absent.filter((k) => filter.has(k)).length, falsePositives);
+
+  // Fixed-width keys in one buffer, and a seed that changes every hash.
+  const ids = crypto.randomBytes(8 * 1000);
+  const seeded = new XXH3BloomFilter(1000, 0.001, 7n);
+  seeded.addMany(ids, 8);
+  assert.ok(seeded.hasMany(Array.from({ length: 1000 }, (_, i) => ids.subarray(i * 8, i * 8 + 8))).every((v) => v === 1));
+
+  const state = filter.exportState();
+  const restored = XXH3BloomFilter.importState(state);
+  assert.ok(restored instanceof XXH3BloomFilter);
+  assert.deepStrictEqual(restored.exportState(), state);
+  assert.deepStrictEqual(restored.hasMany(absent), filter.hasMany(absent));
+  assert.ok(XXH3BloomFilter.importState(seeded.exportState()).hasMany(ids, 8).every((v) => v === 1));
+
+  const set = new XXH3HashSet();
+  const reference = new Set();
+  const stream = Array.from({ length: 60000 }, (_, i) => `event-${(i * 7919) % 25000}`);
+  const fresh = set.addMany(stream.slice(0, 30000));
+  stream.slice(0, 30000).forEach((k, i) => {
+    assert.strictEqual(fresh[i], reference.has(k) ? 0 : 1);
+    reference.add(k);
+  });
+  for (const k of stream.slice(30000)) {
+    assert.strictEqual(set.add(k), !reference.has(k));
+    reference.add(k);
+  }
+  assert.strictEqual(set.size, reference.size);
+  assert.ok(set.hasMany(...pack(keys.slice(0, 25000))).every((v) => v === 1));
+  assert.ok(set.hasMany(absent).every((v) => v === 0));
+  assert.strictEqual(set.has('event-24999'), true);
+  assert.strictEqual(set.has('event-25000'), false);
+
+  const setState = set.exportState();
+  const copy = XXH3HashSet.importState(setState);
+  assert.ok(copy instanceof XXH3HashSet);
+  assert.strictEqual(copy.size, set.size);
+  assert.ok(copy.hasMany(keys.slice(0, 25000)).every((v) => v === 1));
+  assert.strictEqual(copy.add('event-25000'), true);
+  assert.strictEqual(set.has('event-25000'), false);
+  assert.strictEqual(new XXH3HashSet(0, 5).add('a'), true);
+  assert.strictEqual(XXH3HashSet.importState(new XXH3HashSet(10, 5).exportState()).size, 0);
+
+  const flipped = Buffer.from(setState);
+  flipped[30] ^= 1;
+  assert.throws(() => XXH3HashSet.importState(flipped), /checksum mismatch/);
+  assert.throws(() => XXH3HashSet.importState(state), /different class/);
+  assert.throws(() => XXH3BloomFilter.importState(setState), /different class/);
+  assert.throws(() => XXH3BloomFilter.importState(), TypeError);
+  assert.throws(() => new XXH3BloomFilter(0), RangeError);
+  assert.throws(() => new XXH3BloomFilter(100, 1), RangeError);
+  assert.throws(() => new XXH3BloomFilter(1e15, 1e-300), RangeError);
+  assert.throws(() => new XXH3HashSet(-1), RangeError);
+  for (const keys of [42, 'keys', { length: 2 }, null]) {
+    assert.throws(() => filter.addMany(keys, 1), TypeError);
+    assert.throws(() => set.hasMany(keys, 1), TypeError);
+  }
+  assert.throws(() => filter.hasMany(Buffer.alloc(10)), TypeError);
+  assert.throws(() => set.addMany(Buffer.alloc(10), 3), RangeError);
+  assert.throws(() => set.has(), RangeError);
+}
+
+// ── SIMD backends ──
+
+console.log('getSimdBackend/setSimdBackend - every backend gives the same hashes');
+{
+  const backends = listSimdBackends();
+  const initial = getSimdBackend();
+  assert.ok(backends.includes('scalar'));
+  assert.ok(backends.includes(initial));
+
+  // Lengths either side of 240 bytes, where XXH3 switches to the vector loop.
+  const data = crypto.randomBytes(100003);
+  const secret = crypto.randomBytes(192);
+  const lengths = [0, 17, 240, 241, 1024, 1025, data.length];
+  const digests = () => {
+    const out = [];
+    for (const len of lengths) {
+      const input = data.subarray(0, len);
+      out.push(XXHash3.hash(input), XXHash3.hash(input, 42), XXHash3.hash(input, secret),
+               XXHash128.hash(input), XXHash128.hash(input, 42n), XXHash128.hash(input, secret));
+    }
+    for (const Cls of [XXHash3, XXHash128]) {
+      const hasher = new Cls(secret);
+      for (let i = 0; i < data.length; i += 777) hasher.update(data.subarray(i, i + 777));
+      out.push(hasher.digest());
+    }
+    return out;
+  };
+
+  setSimdBackend('scalar');
+  const expected = digests();
+  for (const name of backends) {
+    assert.strictEqual(setSimdBackend(name), name);
+    assert.strictEqual(getSimdBackend(), name);
+    assert.deepStrictEqual(digests(), expected, name);
+  }
+  assert.strictEqual(setSimdBackend('auto'), backends[backends.length - 1]);
+  assert.throws(() => setSimdBackend('mmx'), RangeError);
+  assert.throws(() => setSimdBackend(), TypeError);
+  setSimdBackend(initial);
+
+  const load = (value) => childProcess.spawnSync(process.execPath, ['-e',
+    `console.log(require(${JSON.stringify(require.resolve('./xxhash-addon'))}).getSimdBackend())`],
+    { env: { ...process.env, XXHASH_ADDON_SIMD: value }, encoding: 'utf8' });
+  assert.strictEqual(load('scalar').stdout.trim(), 'scalar');
+  // An unusable name warns and falls back rather than failing require().
+  const rejected = load('mmx');
+  assert.strictEqual(rejected.status, 0);
+  assert.strictEqual(rejected.stdout.trim(), backends[backends.length - 1]);
+  assert.match(rejected.stderr, /XXHASH_ADDON_SIMD names an unknown/);
+}
+
+// ── Native baseline ──
+
+console.log('_nativeHashLoop - the benchmark baseline makes the same calls as hash()');
+{
+  const key = Buffer.from('latency');
+  const fold = (digest) => digest.length === 16
+    ? digest.readBigUInt64BE(0) ^ digest.readBigUInt64BE(8)
+    : BigInt('0x' + digest.toString('hex'));
+  for (const [name, Cls] of [['XXH32', XXHash32], ['XXH64', XXHash64], ['XXH3', XXHash3], ['XXH128', XXHash128]]) {
+    assert.strictEqual(_nativeHashLoop(name, key, 1), fold(Cls.hash(key)), name);
+    assert.strictEqual(_nativeHashLoop(name, key, 1, true), fold(Cls.hash(key)), name);
+    assert.strictEqual(_nativeHashLoop(name, key, 2), 0n);
+    assert.strictEqual(_nativeHashLoop(name, key, 0, true), 0n);
+  }
+  assert.throws(() => _nativeHashLoop('MD5', key, 1), RangeError);
+  assert.throws(() => _nativeHashLoop('XXH3', key, -1), RangeError);
+  assert.throws(() => _nativeHashLoop('XXH3', 42, 1), TypeError);
+}
+
+// ── Call statistics ──
+
+console.log('getStats/resetStats - opt-in per-class call counters and histograms');
+{
+  const initial = getStats();
+  const classOf = (name) => getStats().classes[name];
+  resetStats();
+  enableStats(1);
+  XXHash64.hash(Buffer.alloc(100));
+  XXHash64.hashBigInt(Buffer.alloc(3));
+  XXHash3.hashInto(Buffer.alloc(0), Buffer.alloc(8));
+  const h = new XXHash128(buf_seed);
+  h.update(Buffer.alloc(1000));
+  h.update('abc');
+  h.digest();
+  h.digestInto(Buffer.alloc(16));
+  disableStats();
+  // Nothing is counted while statistics are off.
+  XXHash64.hash(Buffer.alloc(100));
+  h.update('more');
+
+  const stats = getStats();
+  assert.strictEqual(stats.enabled, false);
+  assert.strictEqual(stats.sampleEvery, 1);
+  assert.deepStrictEqual(Object.keys(stats.classes), ['XXH32', 'XXH64', 'XXH3', 'XXH128']);
+  const xxh64 = classOf('XXH64').hash;
+  assert.strictEqual(xxh64.calls, 2);
+  assert.strictEqual(xxh64.bytes, 103);
+  assert.strictEqual(xxh64.sizes.length, 33);
+  assert.deepStrictEqual([xxh64.sizes[2], xxh64.sizes[7]], [1, 1]); // 2-3 and 64-127 bytes
+  assert.strictEqual(xxh64.latencyNs.reduce((a, b) => a + b), 2);
+  assert.strictEqual(classOf('XXH3').hash.sizes[0], 1);
+  const xxh128 = classOf('XXH128');
+  assert.deepStrictEqual([xxh128.update.calls, xxh128.update.bytes], [2, 1003]);
+  assert.deepStrictEqual([xxh128.update.sizes[2], xxh128.update.sizes[10]], [1, 1]);
+  assert.deepStrictEqual([xxh128.digest.calls, xxh128.digest.bytes], [2, 0]);
+  assert.strictEqual(classOf('XXH32').hash.calls, 0);
+
+  // Timing off: calls still counted, no latency samples.
+  enableStats(0);
+  XXHash32.hash('x');
+  assert.strictEqual(classOf('XXH32').hash.calls, 1);
+  assert.strictEqual(classOf('XXH32').hash.latencyNs.reduce((a, b) => a + b), 0);
+  assert.throws(() => enableStats(-1), RangeError);
+  assert.throws(() => enableStats('often'), TypeError);
+
+  resetStats();
+  assert.strictEqual(classOf('XXH128').update.calls, 0);
+  assert.strictEqual(classOf('XXH64').hash.sizes[7], 0);
+  if (initial.enabled) enableStats(initial.sampleEvery); else disableStats();
+
+  const load = (value) => JSON.parse(childProcess.spawnSync(process.execPath, ['-e',
+    `const a = require(${JSON.stringify(require.resolve('./xxhash-addon'))});
+     a.XXHash3.hash('abc');
+     const s = a.getStats();
+     console.log(JSON.stringify([s.enabled, s.sampleEvery, s.classes.XXH3.hash.calls]))`],
+    { env: { ...process.env, XXHASH_ADDON_STATS: value }, encoding: 'utf8' }).stdout);
+  assert.deepStrictEqual(load(''), [false, 0, 0]);
+  assert.deepStrictEqual(load('0'), [false, 0, 0]);
+  assert.deepStrictEqual(load('1'), [true, 1, 1]);
+  assert.deepStrictEqual(load('on'), [true, 0, 1]);
+}
+
+// ── Cloning ──
+
+console.log('clone()/cloneInto() - fork a hasher after a shared prefix');
+for (const [Cls, key] of [[XXHash32, buf_seed], [XXHash64, big_seed], [XXHash3, big_seed], [XXHash3, secret], [XXHash128, buf_seed], [XXHash128, secret]]) {
+  const streamed = (...parts) => {
+    const h = new Cls(key);
+    for (const part of parts) h.update(part);
+    return h.digest();
+  };
+  // A prefix longer than one XXH3 stripe block, so the clone carries real state.
+  const prefix = sanityBuffer.slice(0, 1500);
+  const base = new Cls(key);
+  base.update(prefix);
+
+  const a = base.clone();
+  const b = base.clone();
+  assert.ok(a instanceof Cls);
+  a.update('message A');
+  b.update(sanityBuffer.slice(1500, 2240));
+  assert.deepStrictEqual(a.digest(), streamed(prefix, 'message A'));
+  assert.deepStrictEqual(b.digest(), streamed(prefix, sanityBuffer.slice(1500, 2240)));
+  assert.deepStrictEqual(base.digest(), streamed(prefix));
+
+  // Clones are independent of their source, and of its secret.
+  const c = a.clone();
+  base.reset();
+  base.update('other');
+  a.update('more');
+  assert.deepStrictEqual(c.digest(), streamed(prefix, 'message A'));
+  c.reset();
+  assert.deepStrictEqual(c.digest(), streamed());
+
+  // cloneInto() forks into an existing hasher, replacing its seed or secret.
+  const scratch = new Cls(key === secret ? Buffer.alloc(8) : Cls === XXHash3 || Cls === XXHash128 ? secret : Buffer.alloc(4));
+  a.cloneInto(scratch);
+  assert.deepStrictEqual(scratch.digest(), a.digest());
+  scratch.reset();
+  assert.deepStrictEqual(scratch.digest(), streamed());
+  a.cloneInto(a);
+  assert.deepStrictEqual(a.digest(), streamed(prefix, 'message A', 'more'));
+  assert.throws(() => a.cloneInto(new (Cls === XXHash3 ? XXHash128 : XXHash3)(big_seed)), TypeError);
+  assert.throws(() => a.cloneInto({}), TypeError);
+
+  // Hashers recycled through the pool start from a clean state.
+  for (let i = 0; i < 200; i++) new Cls(key).update(sanityBuffer);
+  assert.deepStrictEqual(new Cls(key).digest(), streamed());
+}
+
+// ── Exported state ──
+
+console.log('exportState()/importState() - resume a hash from a checkpoint');
+for (const [Cls, key] of [[XXHash32, buf_seed], [XXHash64, big_seed], [XXHash3, big_seed], [XXHash3, secret], [XXHash128, buf_seed], [XXHash128, secret]]) {
+  for (const split of [0, 5, 100, 1500, 2240]) {
+    const head = sanityBuffer.slice(0, split);
+    const tail = sanityBuffer.slice(split, 2240);
+    const h = new Cls(key);
+    h.update(head);
+    const state = h.exportState();
+    const resumed = Cls.importState(state);
+    assert.ok(resumed instanceof Cls);
+    assert.deepStrictEqual(resumed.exportState(), state);
+    resumed.update(tail);
+    assert.deepStrictEqual(resumed.digest(), Cls.hash(sanityBuffer.slice(0, 2240), key === secret ? secret : key.length === 4 ? key.readUInt32BE() : key.readBigUInt64BE()));
+    // The seed or secret travels with the state, so reset() works too.
+    resumed.reset();
+    assert.deepStrictEqual(resumed.digest(), new Cls(key).digest());
+  }
+
+  const state = new Cls(key).exportState();
+  const other = Cls === XXHash3 ? XXHash128 : XXHash3;
+  const flipped = Buffer.from(state);
+  flipped[20] ^= 1;
+  const future = Buffer.from(state);
+  future[4] = 2;
+  assert.throws(() => Cls.importState(flipped), /checksum mismatch/);
+  assert.throws(() => Cls.importState(state.slice(0, state.length - 1)), /checksum mismatch/);
+  assert.throws(() => Cls.importState(state.slice(0, 10)), /not an exported state/);
+  assert.throws(() => Cls.importState(Buffer.alloc(0)), /not an exported state/);
+  assert.throws(() => Cls.importState(future), /unsupported version/);
+  assert.throws(() => other.importState(state), /different class/);
+  assert.throws(() => Cls.importState(), TypeError);
+  assert.throws(() => Cls.importState(42), TypeError);
+}
+{
+  // The format is little-endian and fixed; this blob must import anywhere.
+  // Fields: header, seed, total length, large flag, lanes, buffered size, buffer.
+  const h = new XXHash32(Buffer.from([0, 0, 0, 42]));
+  h.update('abc');
+  const golden = '5858485301010000' + '2a000000' + '03000000' + '00000000' +
+    '52442324' + 'a1caeb85' + '2a000000' + '7986c861' + '03000000' +
+    '61626300000000000000000000000000';
+  const blob = h.exportState();
+  assert.strictEqual(blob.toString('hex', 0, blob.length - 8), golden);
+  const resumed = XXHash32.importState(blob);
+  resumed.update('def');
+  assert.strictEqual(resumed.digestNumber(), XXHash32.hashNumber('abcdef', 42));
+}
+
+// ── Asynchronous hashing ──
+
+(async () => {
+  console.log('hashAsync/updateAsync/digestAsync - match sync results');
+  for (const [Cls, seedBuf] of [[XXHash32, buf_seed], [XXHash64, buf_seed], [XXHash3, big_seed], [XXHash128, buf_seed]]) {
+    const data = sanityBuffer.slice(0, 2240);
+    assert.deepStrictEqual(await Cls.hashAsync(data), Cls.hash(data));
+
+    const syncHasher = new Cls(seedBuf);
+    syncHasher.update(data.slice(0, 1));
+    syncHasher.update(data.slice(1));
+
+    // Updates issued without awaiting are queued and applied in call order.
+    const asyncHasher = new Cls(seedBuf);
+    const pending = [asyncHasher.updateAsync(data.slice(0, 1)), asyncHasher.updateAsync(data.slice(1))];
+    const digest = asyncHasher.digestAsync();
+    assert.throws(() => asyncHasher.update(data), /async operation in flight/);
+    assert.throws(() => asyncHasher.digest(), /async operation in flight/);
+    assert.throws(() => asyncHasher.reset(), /async operation in flight/);
+    assert.throws(() => asyncHasher.clone(), /async operation in flight/);
+    assert.throws(() => asyncHasher.exportState(), /async operation in flight/);
+    assert.deepStrictEqual(await Promise.all(pending), [undefined, undefined]);
+    assert.deepStrictEqual(await digest, syncHasher.digest());
+
+    // Strings are copied when the call is made, not when the work runs.
+    const strHasher = new Cls(seedBuf);
+    const strPending = [strHasher.updateAsync('😀'.repeat(300)), strHasher.updateAsync('abc')];
+    const strReference = new Cls(seedBuf);
+    strReference.update(Buffer.from('😀'.repeat(300) + 'abc'));
+    assert.deepStrictEqual(await strHasher.digestAsync(), strReference.digest());
+    await Promise.all(strPending);
+    assert.deepStrictEqual(await Cls.hashAsync('xxhash'), Cls.hash('xxhash'));
+    assert.deepStrictEqual(await Cls.hashAsync(new Uint16Array(new Uint8Array(data.slice(0, 16)).buffer)), Cls.hash(data.slice(0, 16)));
+    // Bad arguments reject the Promise instead of throwing at the call site.
+    await assert.rejects(Cls.hashAsync(42), TypeError);
+    await assert.rejects(Cls.hashAsync({}), TypeError);
+    await assert.rejects(new Cls(seedBuf).updateAsync(null), TypeError);
+
+    // Sync calls work again once the queue has drained.
+    asyncHasher.reset();
+    asyncHasher.update(data);
+    assert.deepStrictEqual(asyncHasher.digest(), syncHasher.digest());
+  }
+
+  console.log('hashFile/hashFileAsync - whole files and ranges');
+  {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'xxhash-addon-'));
+    try {
+      // 3 MB crosses the mmap threshold; 222 bytes takes the pread path.
+      const big = Buffer.alloc(3 << 20);
+      for (let i = 0; i < big.length; i += sanityBuffer.length) sanityBuffer.copy(big, i);
+      const files = [['small', sanityBuffer.slice(0, 222)], ['big', big], ['empty', Buffer.alloc(0)]];
+      for (const [name, content] of files) fs.writeFileSync(path.join(dir, name), content);
+
+      for (const Cls of [XXHash32, XXHash64, XXHash3, XXHash128]) {
+        for (const [name, content] of files) {
+          const file = path.join(dir, name);
+          assert.deepStrictEqual(Cls.hashFile(file), Cls.hash(content));
+          assert.deepStrictEqual(await Cls.hashFileAsync(file), Cls.hash(content));
+        }
+        const file = path.join(dir, 'big');
+        assert.deepStrictEqual(Cls.hashFile(file, 4097), Cls.hash(big.subarray(4097)));
+        assert.deepStrictEqual(Cls.hashFile(file, 4097, 2 << 20), Cls.hash(big.subarray(4097, 4097 + (2 << 20))));
+        assert.deepStrictEqual(await Cls.hashFileAsync(file, 13, 100), Cls.hash(big.subarray(13, 113)));
+        // Ranges past EOF are clamped like fs.createReadStream().
+        assert.deepStrictEqual(Cls.hashFile(file, big.length + 1), Cls.hash(Buffer.alloc(0)));
+        assert.deepStrictEqual(Cls.hashFile(file, big.length - 5, 100), Cls.hash(big.subarray(-5)));
+        // Infinity reads to EOF; NaN and fractions are not truncated.
+        assert.deepStrictEqual(Cls.hashFile(file, 0, Infinity), Cls.hash(big));
+        assert.deepStrictEqual(await Cls.hashFileAsync(file, 13, Infinity), Cls.hash(big.subarray(13)));
+        for (const bad of [1.5, NaN, Infinity, -Infinity, 2 ** 53, '1']) {
+          assert.throws(() => Cls.hashFile(file, bad), RangeError, String(bad));
+        }
+        for (const bad of [1.5, NaN, -Infinity, -1]) {
+          assert.throws(() => Cls.hashFile(file, 0, bad), RangeError, String(bad));
+        }
+        await assert.rejects(Cls.hashFileAsync(file, 0, 1.5), RangeError);
+
+        const missing = path.join(dir, 'missing');
+        assert.throws(() => Cls.hashFile(missing), { code: 'ENOENT' });
+        await assert.rejects(Cls.hashFileAsync(missing), { code: 'ENOENT' });
+        await assert.rejects(Cls.hashFileAsync(42), TypeError);
+        await assert.rejects(Cls.hashFileAsync(file, -1), RangeError);
+        assert.throws(() => Cls.hashFile(file, -1), RangeError);
+        assert.throws(() => Cls.hashFile(42), TypeError);
+      }
+    } finally {
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  }
+
+  console.log('\nAll tests passed.');
+})().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});